@@ -0,0 +1,128 @@
+#version 460 core
+
+layout (local_size_x = 64) in;
+
+struct ObjectData
+{
+    uint transformIndex;
+    uint baseColorIndex;
+    uint normalIndex;
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct Bounds
+{
+    vec4 minimum;
+    vec4 maximum;
+};
+
+layout (binding = 0) readonly buffer BObjectData
+{
+    ObjectData[] objectData;
+};
+
+layout (binding = 1) readonly buffer BTransforms
+{
+    mat4[] transforms;
+};
+
+layout (binding = 2) readonly buffer BBounds
+{
+    Bounds[] bounds;
+};
+
+layout (binding = 3) buffer BDrawCommands
+{
+    DrawCommand[] drawCommands;
+};
+
+layout (binding = 4) buffer BStatistics
+{
+    uint testedMeshes;
+    uint frustumRejectedMeshes;
+    uint occlusionRejectedMeshes;
+};
+
+layout (binding = 0) uniform sampler2D uHiZ;
+
+layout (location = 0) uniform mat4 uProjection;
+layout (location = 1) uniform mat4 uView;
+layout (location = 2) uniform uint uDrawCount;
+
+void main()
+{
+    const uint drawIndex = gl_GlobalInvocationID.x;
+    // already rejected on the CPU
+    if (drawIndex >= uDrawCount || drawCommands[drawIndex].instanceCount == 0)
+    {
+        return;
+    }
+
+    const uint transformIndex = objectData[drawIndex].transformIndex;
+    const mat4 worldViewProjection = uProjection * uView * transforms[transformIndex];
+    const vec3 boundsMin = bounds[transformIndex].minimum.xyz;
+    const vec3 boundsMax = bounds[transformIndex].maximum.xyz;
+
+    vec3 ndcMin = vec3(1.0);
+    vec3 ndcMax = vec3(-1.0);
+    bool crossesNearPlane = false;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const vec3 position = mix(boundsMin, boundsMax, vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1));
+        const vec4 clip = worldViewProjection * vec4(position, 1.0);
+        if (clip.w <= 0.0)
+        {
+            crossesNearPlane = true;
+            break;
+        }
+        const vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+
+    bool isVisible = true;
+    if (!crossesNearPlane)
+    {
+        // every corner is in front of the camera here, so z above 1 is past the far plane
+        if (any(lessThan(ndcMax.xy, vec2(-1.0))) || any(greaterThan(ndcMin.xy, vec2(1.0))) || ndcMin.z > 1.0)
+        {
+            isVisible = false;
+            atomicAdd(frustumRejectedMeshes, 1);
+        }
+        else
+        {
+            // pick the level where the screen rectangle covers at most 2x2 texels
+            const vec2 uvMin = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0);
+            const vec2 uvMax = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0);
+            const vec2 size = (uvMax - uvMin) * vec2(textureSize(uHiZ, 0));
+            const int levelCount = textureQueryLevels(uHiZ);
+            const int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, levelCount - 1);
+
+            const ivec2 levelSize = textureSize(uHiZ, level);
+            const ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+            const ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+            float occluderDepth = texelFetch(uHiZ, texelMin, level).r;
+            occluderDepth = max(occluderDepth, texelFetch(uHiZ, ivec2(texelMax.x, texelMin.y), level).r);
+            occluderDepth = max(occluderDepth, texelFetch(uHiZ, ivec2(texelMin.x, texelMax.y), level).r);
+            occluderDepth = max(occluderDepth, texelFetch(uHiZ, texelMax, level).r);
+
+            const float nearestDepth = ndcMin.z * 0.5 + 0.5;
+            if (nearestDepth > occluderDepth)
+            {
+                isVisible = false;
+                atomicAdd(occlusionRejectedMeshes, 1);
+            }
+        }
+    }
+
+    atomicAdd(testedMeshes, 1);
+    drawCommands[drawIndex].instanceCount = isVisible ? 1 : 0;
+}
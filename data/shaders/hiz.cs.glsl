@@ -0,0 +1,47 @@
+#version 460 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2D uDepth;
+
+layout (binding = 0, r32f) uniform readonly image2D uSource;
+layout (binding = 1, r32f) uniform writeonly image2D uDestination;
+
+// 0 copies the depth buffer into the first level, everything else reduces the previous level
+layout (location = 0) uniform int uLevel;
+
+void main()
+{
+    const ivec2 destinationSize = imageSize(uDestination);
+    const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= destinationSize.x || texel.y >= destinationSize.y)
+    {
+        return;
+    }
+
+    if (uLevel == 0)
+    {
+        imageStore(uDestination, texel, vec4(texelFetch(uDepth, texel, 0).r));
+        return;
+    }
+
+    // keep the farthest depth, odd sized sources fold their last row/column into the neighbouring texel
+    const ivec2 sourceSize = imageSize(uSource);
+    const ivec2 sourceTexel = texel * 2;
+    float depth = imageLoad(uSource, sourceTexel).r;
+    depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(1, 0), sourceSize - 1)).r);
+    depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(0, 1), sourceSize - 1)).r);
+    depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(1, 1), sourceSize - 1)).r);
+    if ((sourceSize.x & 1) != 0 && texel.x == destinationSize.x - 1)
+    {
+        depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(2, 0), sourceSize - 1)).r);
+        depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(2, 1), sourceSize - 1)).r);
+    }
+    if ((sourceSize.y & 1) != 0 && texel.y == destinationSize.y - 1)
+    {
+        depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(0, 2), sourceSize - 1)).r);
+        depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(1, 2), sourceSize - 1)).r);
+        depth = max(depth, imageLoad(uSource, min(sourceTexel + ivec2(2, 2), sourceSize - 1)).r);
+    }
+    imageStore(uDestination, texel, vec4(depth));
+}
@@ -4,10 +4,97 @@ layout (location = 0) out vec4 oPixel;
 
 layout (location = 0) in vec2 iUvs;
 layout (location = 1) in flat uint iBaseColorIndex;
+layout (location = 2) in vec3 iWorldPosition;
+layout (location = 3) in vec3 iWorldNormal;
 
+layout (location = 1) uniform mat4 uView;
 layout (location = 2) uniform sampler2D[16] uTextures;
+// tiles x, tiles y, slices
+layout (location = 18) uniform uvec3 uClusterGrid;
+layout (location = 19) uniform vec2 uClusterTileSize;
+// slice = floor(log(view depth) * scale + bias)
+layout (location = 20) uniform vec2 uClusterSliceScaleBias;
+layout (location = 21) uniform bool uIsLightingEnabled;
+
+struct Light
+{
+    vec3 position;
+    float range;
+    vec3 color;
+    float intensity;
+    vec3 direction;
+    float spotOuterCos;
+    float spotInnerCos;
+};
+
+struct ClusterLightRange
+{
+    uint offset;
+    uint count;
+};
+
+layout (binding = 5) readonly buffer BLights
+{
+    Light[] lights;
+};
+
+layout (binding = 6) readonly buffer BClusters
+{
+    ClusterLightRange[] clusters;
+};
+
+layout (binding = 7) readonly buffer BLightIndices
+{
+    uint[] lightIndices;
+};
+
+const vec3 ambient = vec3(0.05);
+
+uint GetClusterIndex()
+{
+    const float viewDepth = -(uView * vec4(iWorldPosition, 1.0)).z;
+    const uint slice = uint(clamp(
+        floor(log(viewDepth) * uClusterSliceScaleBias.x + uClusterSliceScaleBias.y),
+        0.0,
+        float(uClusterGrid.z - 1)));
+    const uvec2 tile = min(uvec2(gl_FragCoord.xy / uClusterTileSize), uClusterGrid.xy - 1);
+    return (slice * uClusterGrid.y + tile.y) * uClusterGrid.x + tile.x;
+}
+
+vec3 ShadeLight(Light light, vec3 normal)
+{
+    const vec3 toLight = light.position - iWorldPosition;
+    const float distanceSquared = dot(toLight, toLight);
+    const vec3 lightDirection = toLight * inversesqrt(max(distanceSquared, 1e-8));
+
+    // windowed inverse square falloff, reaches 0 at the range the light was clustered with
+    const float ratio = distanceSquared / (light.range * light.range);
+    const float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+    float attenuation = window * window / max(distanceSquared, 1e-4);
+    if (light.spotOuterCos > -1.0)
+    {
+        attenuation *= smoothstep(light.spotOuterCos, light.spotInnerCos, dot(-lightDirection, light.direction));
+    }
+
+    return light.color * light.intensity * attenuation * max(dot(normal, lightDirection), 0.0);
+}
 
 void main()
 {
-    oPixel = vec4(texture(uTextures[iBaseColorIndex], iUvs).rgb, 1.0);
-}
\ No newline at end of file
+    const vec3 baseColor = texture(uTextures[iBaseColorIndex], iUvs).rgb;
+    if (!uIsLightingEnabled)
+    {
+        oPixel = vec4(baseColor, 1.0);
+        return;
+    }
+
+    const vec3 normal = normalize(iWorldNormal);
+    const ClusterLightRange cluster = clusters[GetClusterIndex()];
+    vec3 radiance = ambient;
+    for (uint i = 0; i < cluster.count; ++i)
+    {
+        radiance += ShadeLight(lights[lightIndices[cluster.offset + i]], normal);
+    }
+
+    oPixel = vec4(baseColor * radiance, 1.0);
+}
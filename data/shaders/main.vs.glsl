@@ -5,8 +5,13 @@ layout (location = 1) in vec3 iNormal;
 layout (location = 2) in vec2 iUv;
 layout (location = 3) in vec4 iTangent;
 
+// the depth pre-pass runs this shader too, both have to produce the exact same depth
+invariant gl_Position;
+
 layout (location = 0) out vec2 oUvs;
 layout (location = 1) out flat uint oBaseColorIndex;
+layout (location = 2) out vec3 oWorldPosition;
+layout (location = 3) out vec3 oWorldNormal;
 
 layout (location = 0) uniform mat4 uProjection;
 layout (location = 1) uniform mat4 uView;
@@ -32,5 +37,8 @@ void main()
 {
     oUvs = iUv;
     oBaseColorIndex = objectData[gl_DrawID].baseColorIndex;
-    gl_Position = uProjection * uView * transforms[objectData[gl_DrawID].transformIndex] * vec4(iPosition, 1.0);
+    const mat4 transform = transforms[objectData[gl_DrawID].transformIndex];
+    oWorldPosition = (transform * vec4(iPosition, 1.0)).xyz;
+    oWorldNormal = transpose(inverse(mat3(transform))) * iNormal;
+    gl_Position = uProjection * uView * transform * vec4(iPosition, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <Project.Benchmarks/Benchmarks.hpp>
+#include <Project.Library/DrawQueue.hpp>
+#include <Project.Library/ThreadPool.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+bool RunKeySortBenchmark()
+{
+    ThreadPool threadPool;
+    RadixSorter sorter;
+    auto isMatching = true;
+    for (const auto keyCount : { 1u << 10, 1u << 14, 1u << 17, 1u << 20 })
+    {
+        // realistic keys, a handful of passes and programs, many materials, random depth
+        std::mt19937 random(1234);
+        std::vector<uint64_t> keys(keyCount);
+        for (auto& key : keys)
+        {
+            key = DrawSortKey::Make(random() % 3, random() % 16, random() % 4096, random());
+        }
+
+        std::vector<uint64_t> radixKeys;
+        std::vector<uint32_t> radixItems(keyCount);
+        const auto radixMilliseconds = MeasureMilliseconds(5, [&]()
+        {
+            sorter.Sort(radixKeys, radixItems, threadPool);
+        }, [&]()
+        {
+            radixKeys = keys;
+            std::iota(radixItems.begin(), radixItems.end(), 0);
+        });
+
+        std::vector<uint64_t> stdKeys;
+        const auto stdMilliseconds = MeasureMilliseconds(5, [&]()
+        {
+            std::sort(stdKeys.begin(), stdKeys.end());
+        }, [&]()
+        {
+            stdKeys = keys;
+        });
+
+        const auto isSorted = radixKeys == stdKeys;
+        isMatching &= isSorted;
+        spdlog::info("Benchmark: {:>7} keys on {} threads, radix {:>7.2f} ms in {} passes, std::sort {:>7.2f} ms{}",
+            keyCount,
+            threadPool.GetThreadCount(),
+            radixMilliseconds,
+            sorter.GetScatterPassCount(),
+            stdMilliseconds,
+            isSorted ? "" : ", RESULTS DIFFER");
+    }
+    return isMatching;
+}
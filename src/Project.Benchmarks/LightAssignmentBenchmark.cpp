@@ -0,0 +1,61 @@
+#include <Project.Benchmarks/Benchmarks.hpp>
+#include <Project.Library/ClusteredLighting.hpp>
+#include <Project.Library/ThreadPool.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <random>
+#include <vector>
+
+bool RunLightAssignmentBenchmark()
+{
+    constexpr float nearPlane = 0.1f;
+    constexpr float farPlane = 256.0f;
+    const auto projection = glm::perspective(glm::radians(80.0f), 16.0f / 9.0f, nearPlane, farPlane);
+    const auto view = glm::lookAt(glm::vec3(0.0f, 4.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    ThreadPool threadPool;
+    ClusteredLighting clusteredLighting;
+    ClusteredLighting reference;
+    clusteredLighting.SetProjection(projection, nearPlane, farPlane);
+    reference.SetProjection(projection, nearPlane, farPlane);
+
+    auto isMatching = true;
+    for (const auto lightCount : { 1000u, 10000u, 100000u })
+    {
+        // a 60 unit scene like the one the app generates its lights in, every fourth light is a spot light
+        std::mt19937 random(lightCount);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<LightData> lights(lightCount);
+        for (auto& light : lights)
+        {
+            light.Position = glm::vec3(unit(random) - 0.5f, unit(random) * 0.25f, unit(random) - 0.5f) * 60.0f;
+            light.Range = 60.0f * (0.02f + unit(random) * 0.06f);
+            if (random() % 4 == 0)
+            {
+                light.Direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) * 2.0f - glm::vec3(1.0f));
+                light.SpotOuterCos = 0.5f + unit(random) * 0.4f;
+                light.SpotInnerCos = (light.SpotOuterCos + 1.0f) * 0.5f;
+            }
+        }
+
+        const auto milliseconds = MeasureMilliseconds(5, [&]() { clusteredLighting.Assign(lights, view, threadPool); });
+        const auto referenceMilliseconds = MeasureMilliseconds(1, [&]() { reference.AssignReference(lights, view); });
+
+        const auto isIdentical =
+            clusteredLighting.GetClusters() == reference.GetClusters() &&
+            clusteredLighting.GetLightIndices() == reference.GetLightIndices();
+        isMatching &= isIdentical;
+        spdlog::info("Benchmark: {:>6} lights on {} threads {:>8.3f} ms, brute force {:>9.2f} ms, {} indices, at most {} lights in a cluster{}",
+            lightCount,
+            threadPool.GetThreadCount(),
+            milliseconds,
+            referenceMilliseconds,
+            clusteredLighting.GetStatistics().LightIndices,
+            clusteredLighting.GetStatistics().MaxLightsPerCluster,
+            isIdentical ? "" : ", RESULTS DIFFER");
+    }
+    return isMatching;
+}
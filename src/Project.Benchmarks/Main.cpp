@@ -0,0 +1,53 @@
+#include <Project.Benchmarks/Benchmarks.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <string_view>
+
+struct Benchmark
+{
+    std::string_view Name;
+    bool (*Run)();
+};
+
+constexpr std::array Benchmarks =
+{
+    Benchmark{ "occlusion", RunSoftwareOcclusionBenchmark },
+    Benchmark{ "keysort", RunKeySortBenchmark },
+    Benchmark{ "lights", RunLightAssignmentBenchmark }
+};
+
+// Runs every benchmark, or only the ones named on the command line
+int main(int argc, char* argv[])
+{
+    auto isMatching = true;
+    auto benchmarksRun = 0;
+    for (const auto& benchmark : Benchmarks)
+    {
+        auto isSelected = argc == 1;
+        for (int32_t i = 1; i < argc; ++i)
+        {
+            isSelected |= benchmark.Name == argv[i];
+        }
+        if (!isSelected)
+        {
+            continue;
+        }
+
+        spdlog::info("Benchmark: {}", benchmark.Name);
+        isMatching &= benchmark.Run();
+        benchmarksRun++;
+    }
+
+    if (benchmarksRun == 0)
+    {
+        spdlog::error("Benchmark: Nothing matched, available are");
+        for (const auto& benchmark : Benchmarks)
+        {
+            spdlog::error("  {}", benchmark.Name);
+        }
+        return 1;
+    }
+    return isMatching ? 0 : 1;
+}
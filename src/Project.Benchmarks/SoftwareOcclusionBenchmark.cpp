@@ -0,0 +1,77 @@
+#include <Project.Benchmarks/Benchmarks.hpp>
+#include <Project.Library/SoftwareOcclusionCulling.hpp>
+#include <Project.Library/ThreadPool.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+bool RunSoftwareOcclusionBenchmark()
+{
+    std::vector<glm::vec3> positions;
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        positions.emplace_back(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+    }
+    std::vector<uint32_t> indices;
+    constexpr uint32_t faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+    for (const auto& face : faces)
+    {
+        indices.insert(indices.end(), { face[0], face[1], face[2], face[0], face[2], face[3] });
+    }
+
+    spdlog::info("Benchmark: AVX2 path {}", SoftwareOcclusionCulling::IsAvx2Enabled() ? "enabled" : "disabled");
+
+    ThreadPool threadPool;
+    auto isMatching = true;
+    for (const auto cubeCount : { 256u, 4096u, 32768u })
+    {
+        for (const auto& [width, height] : { std::pair{ 256u, 128u }, std::pair{ 1024u, 512u } })
+        {
+            const auto projection = glm::perspective(glm::radians(80.0f), static_cast<float>(width) / static_cast<float>(height), 0.1f, 256.0f);
+            const auto view = glm::lookAt(glm::vec3(0.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            std::mt19937 random(cubeCount);
+            std::uniform_real_distribution<float> position(-24.0f, 24.0f);
+            std::uniform_real_distribution<float> scale(0.1f, 1.5f);
+            std::vector<OccluderMesh> occluders(cubeCount);
+            for (auto& occluder : occluders)
+            {
+                const auto world = glm::scale(
+                    glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random) - 16.0f)),
+                    glm::vec3(scale(random)));
+                occluder.Positions = positions.data();
+                occluder.Indices = indices.data();
+                occluder.IndexCount = static_cast<uint32_t>(indices.size());
+                occluder.WorldViewProjection = projection * view * world;
+            }
+
+            SoftwareOcclusionCulling culling(width, height);
+            SoftwareOcclusionCulling reference(width, height);
+            const auto milliseconds = MeasureMilliseconds(10, [&]() { culling.Rasterize(occluders, threadPool); });
+            const auto referenceMilliseconds = MeasureMilliseconds(3, [&]() { reference.RasterizeReference(occluders); });
+
+            const auto& depth = culling.GetDepth();
+            const auto& referenceDepth = reference.GetDepth();
+            const auto isIdentical = std::memcmp(depth.data(), referenceDepth.data(), depth.size() * sizeof(float)) == 0;
+            isMatching &= isIdentical;
+
+            const auto triangles = static_cast<float>(culling.GetStatistics().SubmittedTriangles);
+            spdlog::info("Benchmark: {:>6} triangles at {:>4}x{:<4} {:>8.3f} ms {:>8.0f} triangles/ms on {} threads, reference {:>8.3f} ms {:>8.0f} triangles/ms{}",
+                culling.GetStatistics().SubmittedTriangles,
+                width,
+                height,
+                milliseconds,
+                triangles / milliseconds,
+                threadPool.GetThreadCount(),
+                referenceMilliseconds,
+                triangles / referenceMilliseconds,
+                isIdentical ? "" : ", DEPTH DIFFERS");
+        }
+    }
+    return isMatching;
+}
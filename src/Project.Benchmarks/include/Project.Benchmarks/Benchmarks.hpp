@@ -0,0 +1,29 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Each benchmark logs its results, false when the optimized path disagrees with its reference
+bool RunSoftwareOcclusionBenchmark();
+bool RunKeySortBenchmark();
+bool RunLightAssignmentBenchmark();
+
+// Best of a few runs, the minimum is the least noisy on a shared machine. setup runs untimed before each run
+inline float MeasureMilliseconds(uint32_t runCount, const std::function<void()>& function, const std::function<void()>& setup = {})
+{
+    auto bestMilliseconds = 0.0f;
+    for (uint32_t run = 0; run < runCount; ++run)
+    {
+        if (setup)
+        {
+            setup();
+        }
+        const auto startTime = std::chrono::steady_clock::now();
+        function();
+        const auto milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        bestMilliseconds = run == 0 ? milliseconds : std::min(bestMilliseconds, milliseconds);
+    }
+    return bestMilliseconds;
+}
@@ -33,6 +33,9 @@ void Application::Run()
     double previousTime = glfwGetTime();
     while (!glfwWindowShouldClose(_windowHandle))
     {
+        // may sleep, so input gets sampled as late as the frame allows
+        _framePacer.BeginFrame();
+
         double currentTime = glfwGetTime();
         float deltaTime = static_cast<float>(currentTime - previousTime);
         previousTime = currentTime;
@@ -60,6 +63,26 @@ bool Application::IsKeyPressed(int32_t key)
     return glfwGetKey(_windowHandle, key) == GLFW_PRESS;
 }
 
+void Application::GetFramebufferSize(int32_t& width, int32_t& height)
+{
+    glfwGetFramebufferSize(_windowHandle, &width, &height);
+}
+
+const RenderGraph& Application::GetRenderGraph() const
+{
+    return _renderGraph;
+}
+
+GLStateCache& Application::GetStateCache()
+{
+    return _stateCache;
+}
+
+FramePacer& Application::GetFramePacer()
+{
+    return _framePacer;
+}
+
 bool Application::Initialize()
 {
     if (!glfwInit())
@@ -125,13 +148,17 @@ bool Application::Load()
     }, nullptr);
     glClearColor(0.05f, 0.02f, 0.07f, 1.0f);
 
-    glfwSwapInterval(1);
+    // sets the swap interval too
+    _framePacer.Initialize();
 
     return true;
 }
 
 void Application::Unload()
 {
+    _renderGraph.Release();
+    _framePacer.Release();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     BeforeDestroyUiContext();
@@ -144,18 +171,51 @@ void Application::Render(float dt)
 {
     ZoneScopedC(tracy::Color::Red2);
 
-    RenderScene(dt);
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
+    _renderGraph.Reset();
+    auto backbuffer = BuildRenderGraph(_renderGraph, _renderGraph.ImportTexture("Backbuffer", 0), dt);
+    _renderGraph.AddPass("UI",
+        [&](RenderGraphBuilder& builder)
+        {
+            builder.Read(backbuffer, RenderGraphAccess::Framebuffer);
+            backbuffer = builder.Write(backbuffer, RenderGraphAccess::Framebuffer);
+        },
+        [this, dt](RenderGraphContext&)
+        {
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            {
+                RenderUI(dt);
+                ImGui::Render();
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                ImGui::EndFrame();
+            }
+        });
+
+    const auto isCompiled = _renderGraph.Compile();
+    _framePacer.BeginGpuWork();
+    if (isCompiled)
     {
-        RenderUI(dt);
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        ImGui::EndFrame();
+        // ImGui and pooled objects the graph deleted since last frame left the cache stale
+        _stateCache.BeginFrame();
+        _renderGraph.Execute();
     }
 
-    glfwSwapBuffers(_windowHandle);
+    _framePacer.Present(_windowHandle);
+}
+
+RenderGraphResource Application::BuildRenderGraph(RenderGraph& renderGraph, RenderGraphResource backbuffer, float dt)
+{
+    renderGraph.AddPass("Scene",
+        [&](RenderGraphBuilder& builder)
+        {
+            backbuffer = builder.Write(backbuffer, RenderGraphAccess::Framebuffer);
+        },
+        [this, dt](RenderGraphContext&)
+        {
+            RenderScene(dt);
+        });
+    return backbuffer;
 }
 
 void Application::RenderScene([[maybe_unused]] float dt)
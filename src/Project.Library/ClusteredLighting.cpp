@@ -0,0 +1,414 @@
+#include <Project.Library/ClusteredLighting.hpp>
+#include <Project.Library/ThreadPool.hpp>
+
+#include <glm/vec4.hpp>
+
+#include <tracy/Tracy.hpp>
+
+// SSE2 is part of x86-64, so the vector path needs no runtime check
+#if defined(__SSE2__) || defined(_M_X64)
+#define HAS_SSE_PATH
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Squared distance from c to [min, max] along one axis. Assign rejects tiles on single axes
+// before running the full test, which is only exact because the full test sums these terms
+static float AxisDistanceSquared(float c, float min, float max)
+{
+    const auto distance = c - std::clamp(c, min, max);
+    return distance * distance;
+}
+
+// AxisDistanceSquared against count extents, four at a time where SSE is available.
+// max then min clamps exactly like std::clamp for boxes with min <= max
+static void AxisDistancesSquared(float c, const float* min, const float* max, float* distances, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(HAS_SSE_PATH)
+    const auto center = _mm_set1_ps(c);
+    for (; i + 4 <= count; i += 4)
+    {
+        const auto clamped = _mm_min_ps(_mm_max_ps(center, _mm_loadu_ps(min + i)), _mm_loadu_ps(max + i));
+        const auto distance = _mm_sub_ps(center, clamped);
+        _mm_storeu_ps(distances + i, _mm_mul_ps(distance, distance));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        distances[i] = AxisDistanceSquared(c, min[i], max[i]);
+    }
+}
+
+static bool SphereIntersectsBox(const glm::vec3& center, float radiusSquared, const glm::vec3& min, const glm::vec3& max)
+{
+    const auto distanceSquared =
+        AxisDistanceSquared(center.x, min.x, max.x) +
+        AxisDistanceSquared(center.y, min.y, max.y) +
+        AxisDistanceSquared(center.z, min.z, max.z);
+    return distanceSquared <= radiusSquared;
+}
+
+ClusteredLighting::ClusteredLighting(uint32_t tilesX, uint32_t tilesY, uint32_t slices)
+{
+    // the cluster index of a pair has to fit into 32 bits
+    _tilesX = std::clamp(tilesX, 1u, 256u);
+    _tilesY = std::clamp(tilesY, 1u, 256u);
+    _slices = std::clamp(slices, 1u, 256u);
+    _clusters.resize(static_cast<size_t>(_tilesX) * _tilesY * _slices);
+}
+
+void ClusteredLighting::SetProjection(const glm::mat4& projection, float nearPlane, float farPlane)
+{
+    if (std::memcmp(&projection, &_projection, sizeof(glm::mat4)) == 0 && nearPlane == _nearPlane && farPlane == _farPlane)
+    {
+        return;
+    }
+
+    _projection = projection;
+    _nearPlane = nearPlane;
+    _farPlane = farPlane;
+    _sliceScale = static_cast<float>(_slices) / std::log(farPlane / nearPlane);
+    _sliceBias = -std::log(nearPlane) * _sliceScale;
+
+    // A point at depth d on the edge of a tile at ndc is at ndc * d / projection[0][0] in view
+    // space, the box has to hold the froxel's near and far face
+    _clusterBounds.resize(_clusters.size());
+    _tileMinX.resize(static_cast<size_t>(_slices) * _tilesX);
+    _tileMaxX.resize(static_cast<size_t>(_slices) * _tilesX);
+    _tileMinY.resize(static_cast<size_t>(_slices) * _tilesY);
+    _tileMaxY.resize(static_cast<size_t>(_slices) * _tilesY);
+    for (uint32_t slice = 0; slice < _slices; ++slice)
+    {
+        const auto nearDepth = GetSliceDepth(slice);
+        const auto farDepth = GetSliceDepth(slice + 1);
+        for (uint32_t tileY = 0; tileY < _tilesY; ++tileY)
+        {
+            const auto bottom = (-1.0f + 2.0f * tileY / _tilesY) / projection[1][1];
+            const auto top = (-1.0f + 2.0f * (tileY + 1) / _tilesY) / projection[1][1];
+            for (uint32_t tileX = 0; tileX < _tilesX; ++tileX)
+            {
+                const auto left = (-1.0f + 2.0f * tileX / _tilesX) / projection[0][0];
+                const auto right = (-1.0f + 2.0f * (tileX + 1) / _tilesX) / projection[0][0];
+                auto& bounds = _clusterBounds[GetClusterIndex(tileX, tileY, slice)];
+                bounds.Min = glm::vec3(
+                    std::min(left * nearDepth, left * farDepth),
+                    std::min(bottom * nearDepth, bottom * farDepth),
+                    -farDepth);
+                bounds.Max = glm::vec3(
+                    std::max(right * nearDepth, right * farDepth),
+                    std::max(top * nearDepth, top * farDepth),
+                    -nearDepth);
+
+                _tileMinX[slice * _tilesX + tileX] = bounds.Min.x;
+                _tileMaxX[slice * _tilesX + tileX] = bounds.Max.x;
+                _tileMinY[slice * _tilesY + tileY] = bounds.Min.y;
+                _tileMaxY[slice * _tilesY + tileY] = bounds.Max.y;
+            }
+        }
+    }
+}
+
+void ClusteredLighting::Assign(std::span<const LightData> lights, const glm::mat4& view, ThreadPool& threadPool)
+{
+    ZoneScopedN("Clustered Light Assignment");
+    if (_clusterBounds.empty())
+    {
+        // no projection yet
+        std::fill(_clusters.begin(), _clusters.end(), ClusterLightRange{});
+        _lightIndices.clear();
+        return;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const auto lightCount = static_cast<uint32_t>(lights.size());
+    _lightSpheres.resize(lightCount);
+    _lightSlices.resize(static_cast<size_t>(lightCount) * 2);
+    threadPool.ParallelFor(lightCount, 1024, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (auto light = begin; light < end; ++light)
+        {
+            const auto sphere = GetViewSpaceBounds(lights[light], view);
+            _lightSpheres[light] = sphere;
+            // one slice of slack either way, the log does not have to agree with GetSliceDepth
+            const auto depth = -sphere.Center.z;
+            _lightSlices[light * 2 + 0] = std::max(GetSliceUnclamped(depth - sphere.Radius) - 1, 0);
+            _lightSlices[light * 2 + 1] = std::min(GetSliceUnclamped(depth + sphere.Radius) + 1, static_cast<int32_t>(_slices) - 1);
+        }
+    });
+
+    // Slices own their clusters, so each one is filled by a single thread and needs no atomics.
+    // A box is the product of its tile's x and y extents and its slice's z extent, so the per
+    // axis distances are computed once per light and slice and summed in the reference's order
+    _slicePairs.resize(_slices);
+    threadPool.ParallelFor(_slices, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        std::vector<float> distancesX(_tilesX);
+        std::vector<float> distancesY(_tilesY);
+        for (auto slice = begin; slice < end; ++slice)
+        {
+            auto& pairs = _slicePairs[slice];
+            pairs.clear();
+            const auto firstCluster = GetClusterIndex(0, 0, slice);
+            for (auto cluster = firstCluster; cluster < firstCluster + _tilesX * _tilesY; ++cluster)
+            {
+                _clusters[cluster].Count = 0;
+            }
+
+            const auto& sliceBounds = _clusterBounds[firstCluster];
+            const auto* tileMinX = _tileMinX.data() + slice * _tilesX;
+            const auto* tileMaxX = _tileMaxX.data() + slice * _tilesX;
+            const auto* tileMinY = _tileMinY.data() + slice * _tilesY;
+            const auto* tileMaxY = _tileMaxY.data() + slice * _tilesY;
+            const auto addPair = [&](uint32_t cluster, uint32_t light)
+            {
+                pairs.push_back(static_cast<uint64_t>(cluster) << 32 | light);
+                _clusters[cluster].Count++;
+            };
+
+            for (uint32_t light = 0; light < lightCount; ++light)
+            {
+                if (static_cast<int32_t>(slice) < _lightSlices[light * 2 + 0] || static_cast<int32_t>(slice) > _lightSlices[light * 2 + 1])
+                {
+                    continue;
+                }
+
+                // adding non negative terms never makes the sum smaller, so every axis can reject on its own
+                const auto& sphere = _lightSpheres[light];
+                const auto radiusSquared = sphere.Radius * sphere.Radius;
+                const auto distanceZ = AxisDistanceSquared(sphere.Center.z, sliceBounds.Min.z, sliceBounds.Max.z);
+                if (distanceZ > radiusSquared)
+                {
+                    continue;
+                }
+
+                AxisDistancesSquared(sphere.Center.x, tileMinX, tileMaxX, distancesX.data(), _tilesX);
+                auto minTileX = _tilesX;
+                auto maxTileX = 0u;
+                for (uint32_t tileX = 0; tileX < _tilesX; ++tileX)
+                {
+                    if (distancesX[tileX] <= radiusSquared)
+                    {
+                        minTileX = std::min(minTileX, tileX);
+                        maxTileX = tileX;
+                    }
+                }
+                AxisDistancesSquared(sphere.Center.y, tileMinY, tileMaxY, distancesY.data(), _tilesY);
+                auto minTileY = _tilesY;
+                auto maxTileY = 0u;
+                for (uint32_t tileY = 0; tileY < _tilesY; ++tileY)
+                {
+                    if (distancesY[tileY] <= radiusSquared)
+                    {
+                        minTileY = std::min(minTileY, tileY);
+                        maxTileY = tileY;
+                    }
+                }
+                if (minTileX == _tilesX || minTileY == _tilesY)
+                {
+                    continue;
+                }
+
+                for (auto tileY = minTileY; tileY <= maxTileY; ++tileY)
+                {
+                    const auto distanceY = distancesY[tileY];
+                    const auto rowCluster = GetClusterIndex(0, tileY, slice);
+                    auto tileX = minTileX;
+#if defined(HAS_SSE_PATH)
+                    const auto rowDistance = _mm_set1_ps(distanceY);
+                    const auto sliceDistance = _mm_set1_ps(distanceZ);
+                    const auto radius = _mm_set1_ps(radiusSquared);
+                    for (; tileX + 4 <= maxTileX + 1; tileX += 4)
+                    {
+                        const auto distance = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(distancesX.data() + tileX), rowDistance), sliceDistance);
+                        auto mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(distance, radius)));
+                        while (mask != 0)
+                        {
+                            addPair(rowCluster + tileX + std::countr_zero(mask), light);
+                            mask &= mask - 1;
+                        }
+                    }
+#endif
+                    for (; tileX <= maxTileX; ++tileX)
+                    {
+                        if (distancesX[tileX] + distanceY + distanceZ <= radiusSquared)
+                        {
+                            addPair(rowCluster + tileX, light);
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    uint32_t offset = 0;
+    for (auto& cluster : _clusters)
+    {
+        cluster.Offset = offset;
+        offset += cluster.Count;
+    }
+    _lightIndices.resize(offset);
+
+    // Pairs come in light order, scattering them in order keeps every list sorted
+    threadPool.ParallelFor(_slices, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        std::vector<uint32_t> cursors(_tilesX * _tilesY);
+        for (auto slice = begin; slice < end; ++slice)
+        {
+            const auto firstCluster = GetClusterIndex(0, 0, slice);
+            for (uint32_t cluster = 0; cluster < cursors.size(); ++cluster)
+            {
+                cursors[cluster] = _clusters[firstCluster + cluster].Offset;
+            }
+            for (const auto pair : _slicePairs[slice])
+            {
+                _lightIndices[cursors[(pair >> 32) - firstCluster]++] = static_cast<uint32_t>(pair);
+            }
+        }
+    });
+
+    const auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime);
+    UpdateStatistics(lightCount, elapsed.count());
+}
+
+void ClusteredLighting::AssignReference(std::span<const LightData> lights, const glm::mat4& view)
+{
+    if (_clusterBounds.empty())
+    {
+        // no projection yet
+        std::fill(_clusters.begin(), _clusters.end(), ClusterLightRange{});
+        _lightIndices.clear();
+        return;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<Sphere> spheres;
+    spheres.reserve(lights.size());
+    for (const auto& light : lights)
+    {
+        spheres.push_back(GetViewSpaceBounds(light, view));
+    }
+
+    _lightIndices.clear();
+    for (uint32_t cluster = 0; cluster < _clusters.size(); ++cluster)
+    {
+        const auto& bounds = _clusterBounds[cluster];
+        _clusters[cluster].Offset = static_cast<uint32_t>(_lightIndices.size());
+        for (uint32_t light = 0; light < spheres.size(); ++light)
+        {
+            const auto& sphere = spheres[light];
+            if (SphereIntersectsBox(sphere.Center, sphere.Radius * sphere.Radius, bounds.Min, bounds.Max))
+            {
+                _lightIndices.push_back(light);
+            }
+        }
+        _clusters[cluster].Count = static_cast<uint32_t>(_lightIndices.size()) - _clusters[cluster].Offset;
+    }
+
+    const auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime);
+    UpdateStatistics(static_cast<uint32_t>(lights.size()), elapsed.count());
+}
+
+uint32_t ClusteredLighting::GetTilesX() const
+{
+    return _tilesX;
+}
+
+uint32_t ClusteredLighting::GetTilesY() const
+{
+    return _tilesY;
+}
+
+uint32_t ClusteredLighting::GetSlices() const
+{
+    return _slices;
+}
+
+float ClusteredLighting::GetSliceScale() const
+{
+    return _sliceScale;
+}
+
+float ClusteredLighting::GetSliceBias() const
+{
+    return _sliceBias;
+}
+
+const std::vector<ClusterLightRange>& ClusteredLighting::GetClusters() const
+{
+    return _clusters;
+}
+
+const std::vector<uint32_t>& ClusteredLighting::GetLightIndices() const
+{
+    return _lightIndices;
+}
+
+const ClusteredLightingStatistics& ClusteredLighting::GetStatistics() const
+{
+    return _statistics;
+}
+
+ClusteredLighting::Sphere ClusteredLighting::GetViewSpaceBounds(const LightData& light, const glm::mat4& view)
+{
+    const auto position = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+    if (light.SpotOuterCos <= -1.0f)
+    {
+        return { position, light.Range };
+    }
+
+    // Smallest sphere around the cone: wide cones are bounded by their cap,
+    // narrow ones by the circle through apex and cap rim
+    const auto direction = glm::vec3(view * glm::vec4(light.Direction, 0.0f));
+    const auto cosAngle = std::clamp(light.SpotOuterCos, 0.0f, 1.0f);
+    if (cosAngle < std::sqrt(0.5f))
+    {
+        const auto sinAngle = std::sqrt(1.0f - cosAngle * cosAngle);
+        return { position + direction * (light.Range * cosAngle), light.Range * sinAngle };
+    }
+    const auto radius = light.Range / (2.0f * cosAngle);
+    return { position + direction * radius, radius };
+}
+
+float ClusteredLighting::GetSliceDepth(uint32_t slice) const
+{
+    return _nearPlane * std::pow(_farPlane / _nearPlane, static_cast<float>(slice) / static_cast<float>(_slices));
+}
+
+int32_t ClusteredLighting::GetSliceUnclamped(float viewDepth) const
+{
+    if (viewDepth <= _nearPlane)
+    {
+        return -1;
+    }
+    if (viewDepth >= _farPlane)
+    {
+        return static_cast<int32_t>(_slices);
+    }
+    return static_cast<int32_t>(std::floor(std::log(viewDepth) * _sliceScale + _sliceBias));
+}
+
+uint32_t ClusteredLighting::GetClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const
+{
+    return (slice * _tilesY + tileY) * _tilesX + tileX;
+}
+
+void ClusteredLighting::UpdateStatistics(uint32_t lightCount, float milliseconds)
+{
+    _statistics = {};
+    _statistics.Lights = lightCount;
+    _statistics.LightIndices = static_cast<uint32_t>(_lightIndices.size());
+    for (const auto& cluster : _clusters)
+    {
+        _statistics.OccupiedClusters += cluster.Count > 0;
+        _statistics.MaxLightsPerCluster = std::max(_statistics.MaxLightsPerCluster, cluster.Count);
+    }
+    _statistics.AssignmentMilliseconds = milliseconds;
+}
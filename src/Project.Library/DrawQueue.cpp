@@ -0,0 +1,164 @@
+#include <Project.Library/DrawQueue.hpp>
+#include <Project.Library/ThreadPool.hpp>
+
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Below this a chunk is not worth waking another thread for
+constexpr uint32_t MinimumRadixChunkSize = 16384;
+
+uint32_t DrawSortKey::QuantizeDepth(float normalizedDepth, bool backToFront)
+{
+    constexpr auto maxDepth = static_cast<float>((1u << DepthBits) - 1);
+    const auto depth = std::clamp(normalizedDepth, 0.0f, 1.0f);
+    const auto bucket = static_cast<uint32_t>(std::lround(depth * maxDepth));
+    return backToFront ? Mask(DepthBits) - bucket : bucket;
+}
+
+void RadixSorter::Sort(std::span<uint64_t> keys, std::span<uint32_t> values, ThreadPool& threadPool)
+{
+    ZoneScopedN("Radix Sort");
+    _scatterPassCount = 0;
+    const auto count = static_cast<uint32_t>(keys.size());
+    if (count < 2)
+    {
+        return;
+    }
+
+    const auto hasValues = !values.empty();
+    _keyScratch.resize(count);
+    if (hasValues)
+    {
+        _valueScratch.resize(count);
+    }
+
+    const auto chunkCount = std::clamp((count + MinimumRadixChunkSize - 1) / MinimumRadixChunkSize, 1u, threadPool.GetThreadCount());
+    const auto chunkSize = (count + chunkCount - 1) / chunkCount;
+    _histograms.resize(chunkCount);
+
+    auto* sourceKeys = keys.data();
+    auto* sourceValues = values.data();
+    auto* destinationKeys = _keyScratch.data();
+    auto* destinationValues = _valueScratch.data();
+
+    for (uint32_t shift = 0; shift < 64; shift += RadixBits)
+    {
+        threadPool.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            for (auto chunk = begin; chunk < end; ++chunk)
+            {
+                auto& histogram = _histograms[chunk];
+                histogram.fill(0);
+                const auto last = std::min((chunk + 1) * chunkSize, count);
+                for (auto i = chunk * chunkSize; i < last; ++i)
+                {
+                    histogram[(sourceKeys[i] >> shift) & (RadixSize - 1)]++;
+                }
+            }
+        });
+
+        // histograms become scatter offsets, digit major and chunk minor keeps equal keys in order
+        auto isSingleDigit = false;
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RadixSize; ++digit)
+        {
+            uint32_t digitCount = 0;
+            for (auto& histogram : _histograms)
+            {
+                const auto chunkDigitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += chunkDigitCount;
+                digitCount += chunkDigitCount;
+            }
+            isSingleDigit |= digitCount == count;
+        }
+        if (isSingleDigit)
+        {
+            continue;
+        }
+
+        threadPool.ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+        {
+            // locals, the compiler cannot prove the scatter writes leave the captured pointers alone
+            const auto* inKeys = sourceKeys;
+            const auto* inValues = sourceValues;
+            auto* outKeys = destinationKeys;
+            auto* outValues = destinationValues;
+            for (auto chunk = begin; chunk < end; ++chunk)
+            {
+                auto offsets = _histograms[chunk];
+                const auto last = std::min((chunk + 1) * chunkSize, count);
+                for (auto i = chunk * chunkSize; i < last; ++i)
+                {
+                    const auto key = inKeys[i];
+                    const auto destination = offsets[(key >> shift) & (RadixSize - 1)]++;
+                    outKeys[destination] = key;
+                    if (hasValues)
+                    {
+                        outValues[destination] = inValues[i];
+                    }
+                }
+            }
+        });
+
+        std::swap(sourceKeys, destinationKeys);
+        std::swap(sourceValues, destinationValues);
+        _scatterPassCount++;
+    }
+
+    if (sourceKeys != keys.data())
+    {
+        std::copy(sourceKeys, sourceKeys + count, keys.data());
+        if (hasValues)
+        {
+            std::copy(sourceValues, sourceValues + count, values.data());
+        }
+    }
+}
+
+uint32_t RadixSorter::GetScatterPassCount() const
+{
+    return _scatterPassCount;
+}
+
+void DrawQueue::Clear()
+{
+    _keys.clear();
+    _items.clear();
+}
+
+void DrawQueue::Add(uint64_t key, uint32_t item)
+{
+    _keys.emplace_back(key);
+    _items.emplace_back(item);
+}
+
+void DrawQueue::Sort(ThreadPool& threadPool)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    _sorter.Sort(_keys, _items, threadPool);
+    _sortMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint32_t DrawQueue::GetSize() const
+{
+    return static_cast<uint32_t>(_keys.size());
+}
+
+std::span<const uint64_t> DrawQueue::GetKeys() const
+{
+    return _keys;
+}
+
+std::span<const uint32_t> DrawQueue::GetItems() const
+{
+    return _items;
+}
+
+float DrawQueue::GetSortMilliseconds() const
+{
+    return _sortMilliseconds;
+}
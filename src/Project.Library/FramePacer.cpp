@@ -0,0 +1,412 @@
+#include <Project.Library/FramePacer.hpp>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <thread>
+
+static float ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<float, std::milli>(duration).count();
+}
+
+FrameHistogram::FrameHistogram(float maxMilliseconds, uint32_t binCount)
+    : _maxMilliseconds(maxMilliseconds), _bins(binCount, 0.0f)
+{
+}
+
+void FrameHistogram::Add(float milliseconds)
+{
+    const auto bin = static_cast<size_t>(std::max(milliseconds, 0.0f) / GetBinMilliseconds());
+    _bins[std::min(bin, _bins.size() - 1)] += 1.0f;
+    _sampleCount++;
+}
+
+void FrameHistogram::Reset()
+{
+    std::fill(_bins.begin(), _bins.end(), 0.0f);
+    _sampleCount = 0;
+}
+
+// Upper edge of the bin the percentile (0 to 100) falls into
+float FrameHistogram::GetPercentile(float percentile) const
+{
+    if (_sampleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    const auto threshold = percentile / 100.0f * static_cast<float>(_sampleCount);
+    auto count = 0.0f;
+    for (size_t bin = 0; bin < _bins.size(); ++bin)
+    {
+        count += _bins[bin];
+        if (count >= threshold)
+        {
+            return static_cast<float>(bin + 1) * GetBinMilliseconds();
+        }
+    }
+    return _maxMilliseconds;
+}
+
+float FrameHistogram::GetBinMilliseconds() const
+{
+    return _maxMilliseconds / static_cast<float>(_bins.size());
+}
+
+uint32_t FrameHistogram::GetSampleCount() const
+{
+    return _sampleCount;
+}
+
+const std::vector<float>& FrameHistogram::GetBins() const
+{
+    return _bins;
+}
+
+FramePacer::FramePacer()
+    : _frameTimeHistogram(100.0f, 200), _latencyHistogram(100.0f, 200)
+{
+    _history.reserve(HistorySize);
+}
+
+void FramePacer::Initialize()
+{
+    const auto* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    const auto refreshRate = videoMode != nullptr && videoMode->refreshRate > 0 ? videoMode->refreshRate : 60;
+    _statistics.RefreshMilliseconds = 1000.0f / static_cast<float>(refreshRate);
+    _statistics.IsAdaptiveVsyncSupported =
+        glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+        glfwExtensionSupported("GLX_EXT_swap_control_tear");
+
+    for (auto& frame : _queuedFrames)
+    {
+        glCreateQueries(GL_TIMESTAMP, 1, &frame.StartQuery);
+        glCreateQueries(GL_TIMESTAMP, 1, &frame.EndQuery);
+    }
+    ApplyVsync();
+
+    _inputTime = Clock::now();
+    _deadline = _inputTime;
+    _isInitialized = true;
+}
+
+void FramePacer::Release()
+{
+    for (auto& frame : _queuedFrames)
+    {
+        if (frame.Fence != nullptr)
+        {
+            glDeleteSync(static_cast<GLsync>(frame.Fence));
+            frame.Fence = nullptr;
+        }
+        glDeleteQueries(1, &frame.StartQuery);
+        glDeleteQueries(1, &frame.EndQuery);
+    }
+    _queuedFrameCount = 0;
+    _isInitialized = false;
+}
+
+void FramePacer::BeginFrame()
+{
+    ZoneScopedN("Frame Pacing");
+    if (!_isInitialized)
+    {
+        return;
+    }
+
+    if (_settings.Vsync != _appliedVsync)
+    {
+        ApplyVsync();
+    }
+
+    // collect whatever the GPU is done with, then block until the new frame fits under the cap
+    const auto fenceWaitStart = Clock::now();
+    while (_queuedFrameCount > 0 && RetireOldestFrame(false))
+    {
+    }
+    const auto maxFramesInFlight = std::clamp(_settings.MaxFramesInFlight, 1u, MaxQueuedFrames);
+    while (_queuedFrameCount >= maxFramesInFlight)
+    {
+        RetireOldestFrame(true);
+    }
+    const auto fenceWaitMilliseconds = ToMilliseconds(Clock::now() - fenceWaitStart);
+
+    auto justInTimeWaitMilliseconds = 0.0f;
+    if (_settings.IsJustInTimeEnabled && _frameIndex > 0)
+    {
+        const auto leadMilliseconds = _statistics.PredictedCostMilliseconds + _settings.JustInTimeMarginMilliseconds;
+        const auto wakeTime = _deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(leadMilliseconds));
+        const auto waitStart = Clock::now();
+        if (wakeTime > waitStart)
+        {
+            WaitUntil(wakeTime);
+            justInTimeWaitMilliseconds = ToMilliseconds(Clock::now() - waitStart);
+        }
+    }
+
+    const auto inputTime = Clock::now();
+    auto& frame = _queuedFrames[(_oldestFrame + _queuedFrameCount) % MaxQueuedFrames];
+    frame.Record = {};
+    frame.Record.Frame = _frameIndex;
+    frame.Record.FrameMilliseconds = ToMilliseconds(inputTime - _inputTime);
+    frame.Record.FenceWaitMilliseconds = fenceWaitMilliseconds;
+    frame.Record.JustInTimeWaitMilliseconds = justInTimeWaitMilliseconds;
+    frame.Record.RenderScale = GetRenderScale();
+    glGetInteger64v(GL_TIMESTAMP, &frame.InputGpuTime);
+    _inputTime = inputTime;
+}
+
+void FramePacer::BeginGpuWork()
+{
+    if (!_isInitialized)
+    {
+        return;
+    }
+
+    auto& frame = _queuedFrames[(_oldestFrame + _queuedFrameCount) % MaxQueuedFrames];
+    glQueryCounter(frame.StartQuery, GL_TIMESTAMP);
+}
+
+void FramePacer::Present(GLFWwindow* window)
+{
+    if (!_isInitialized)
+    {
+        glfwSwapBuffers(window);
+        return;
+    }
+
+    auto& frame = _queuedFrames[(_oldestFrame + _queuedFrameCount) % MaxQueuedFrames];
+    frame.Record.CpuMilliseconds = ToMilliseconds(Clock::now() - _inputTime);
+    glQueryCounter(frame.EndQuery, GL_TIMESTAMP);
+    frame.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _queuedFrameCount++;
+    _frameIndex++;
+
+    glfwSwapBuffers(window);
+    _statistics.FramesInFlight = _queuedFrameCount;
+
+    // with vsync the swap returns around the vertical blank, without it the deadlines keep
+    // their own rhythm unless the frame ran past the next one
+    const auto swapTime = Clock::now();
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(GetFramePeriodMilliseconds()));
+    _deadline = _settings.Vsync == VsyncMode::Off && _deadline + period > swapTime
+        ? _deadline + period
+        : swapTime + period;
+}
+
+FramePacingSettings& FramePacer::GetSettings()
+{
+    return _settings;
+}
+
+void FramePacer::SetDynamicResolutionSupported(bool isSupported)
+{
+    _isDynamicResolutionSupported = isSupported;
+    if (!isSupported)
+    {
+        _renderScale = 1.0f;
+    }
+}
+
+float FramePacer::GetRenderScale() const
+{
+    return std::max(std::round(_renderScale * 20.0f) / 20.0f, 0.05f);
+}
+
+void FramePacer::GetRenderSize(int32_t width, int32_t height, int32_t& renderWidth, int32_t& renderHeight) const
+{
+    const auto renderScale = GetRenderScale();
+    renderWidth = std::max(static_cast<int32_t>(static_cast<float>(width) * renderScale + 0.5f), 1);
+    renderHeight = std::max(static_cast<int32_t>(static_cast<float>(height) * renderScale + 0.5f), 1);
+}
+
+const FramePacingStatistics& FramePacer::GetStatistics() const
+{
+    return _statistics;
+}
+
+const FrameHistogram& FramePacer::GetFrameTimeHistogram() const
+{
+    return _frameTimeHistogram;
+}
+
+const FrameHistogram& FramePacer::GetLatencyHistogram() const
+{
+    return _latencyHistogram;
+}
+
+void FramePacer::ResetHistograms()
+{
+    _frameTimeHistogram.Reset();
+    _latencyHistogram.Reset();
+    _history.clear();
+    _historyNext = 0;
+}
+
+bool FramePacer::ExportCsv(std::string_view filePath) const
+{
+    std::ofstream file(filePath.data());
+    if (!file)
+    {
+        spdlog::error("FramePacer: Unable to write {}", filePath);
+        return false;
+    }
+
+    WriteCsv(file);
+    spdlog::info("FramePacer: Wrote {} frames to {}", _history.size(), filePath);
+    return true;
+}
+
+void FramePacer::WriteCsv(std::ostream& file) const
+{
+    file << "frame,frame_ms,cpu_ms,gpu_ms,latency_ms,fence_wait_ms,jit_wait_ms,render_scale\n";
+    for (size_t i = 0; i < _history.size(); ++i)
+    {
+        // oldest first, the history is a ring once full
+        const auto& record = _history[(_history.size() < HistorySize ? i : _historyNext + i) % _history.size()];
+        file << record.Frame << ','
+             << record.FrameMilliseconds << ','
+             << record.CpuMilliseconds << ','
+             << record.GpuMilliseconds << ','
+             << record.LatencyMilliseconds << ','
+             << record.FenceWaitMilliseconds << ','
+             << record.JustInTimeWaitMilliseconds << ','
+             << record.RenderScale << '\n';
+    }
+
+    file << "\nbin_start_ms,frame_time_count,latency_count\n";
+    const auto& frameTimeBins = _frameTimeHistogram.GetBins();
+    const auto& latencyBins = _latencyHistogram.GetBins();
+    for (size_t bin = 0; bin < frameTimeBins.size(); ++bin)
+    {
+        file << static_cast<float>(bin) * _frameTimeHistogram.GetBinMilliseconds() << ','
+             << frameTimeBins[bin] << ','
+             << latencyBins[bin] << '\n';
+    }
+}
+
+void FramePacer::ApplyVsync()
+{
+    auto vsync = _settings.Vsync;
+    if (vsync == VsyncMode::Adaptive && !_statistics.IsAdaptiveVsyncSupported)
+    {
+        spdlog::warn("FramePacer: Adaptive vsync is not supported, using regular vsync");
+        vsync = VsyncMode::On;
+    }
+    glfwSwapInterval(static_cast<int32_t>(vsync));
+    _appliedVsync = _settings.Vsync;
+}
+
+bool FramePacer::RetireOldestFrame(bool isBlocking)
+{
+    auto& frame = _queuedFrames[_oldestFrame];
+    const auto fence = static_cast<GLsync>(frame.Fence);
+    const auto result = glClientWaitSync(
+        fence,
+        isBlocking ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+        isBlocking ? 1'000'000'000 : 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        return false;
+    }
+
+    glDeleteSync(fence);
+    frame.Fence = nullptr;
+    _oldestFrame = (_oldestFrame + 1) % MaxQueuedFrames;
+    _queuedFrameCount--;
+    if (result == GL_WAIT_FAILED)
+    {
+        return true;
+    }
+
+    // the fence signaled, so both timestamps are available without stalling
+    int64_t startTime = 0;
+    int64_t endTime = 0;
+    glGetQueryObjecti64v(frame.StartQuery, GL_QUERY_RESULT, &startTime);
+    glGetQueryObjecti64v(frame.EndQuery, GL_QUERY_RESULT, &endTime);
+
+    auto& record = frame.Record;
+    record.GpuMilliseconds = static_cast<float>(endTime - startTime) / 1e6f;
+    record.LatencyMilliseconds = static_cast<float>(endTime - frame.InputGpuTime) / 1e6f;
+    AddCompletedFrame(record);
+    return true;
+}
+
+void FramePacer::AddCompletedFrame(const FrameRecord& record)
+{
+    if (record.Frame > 0)
+    {
+        _frameTimeHistogram.Add(record.FrameMilliseconds);
+    }
+    _latencyHistogram.Add(record.LatencyMilliseconds);
+    if (_history.size() < HistorySize)
+    {
+        _history.push_back(record);
+    }
+    else
+    {
+        _history[_historyNext] = record;
+    }
+    _historyNext = (_historyNext + 1) % HistorySize;
+
+    const auto cost = std::max(record.CpuMilliseconds, record.GpuMilliseconds);
+    _statistics.PredictedCostMilliseconds = _statistics.PredictedCostMilliseconds > 0.0f
+        ? _statistics.PredictedCostMilliseconds + (cost - _statistics.PredictedCostMilliseconds) * 0.1f
+        : cost;
+    UpdateRenderScale(record.GpuMilliseconds);
+    _statistics.LastFrame = record;
+}
+
+void FramePacer::UpdateRenderScale(float gpuMilliseconds)
+{
+    if (!_settings.IsDynamicResolutionEnabled || !_isDynamicResolutionSupported)
+    {
+        _renderScale = 1.0f;
+        return;
+    }
+    if (gpuMilliseconds <= 0.0f)
+    {
+        return;
+    }
+
+    // GPU time roughly follows the pixel count, so each axis goes with the square root.
+    // Only a fraction of the correction is applied per frame, timings are noisy
+    const auto desiredScale = _renderScale * std::sqrt(_settings.TargetFrameMilliseconds / gpuMilliseconds);
+    _renderScale = std::clamp(
+        _renderScale + (desiredScale - _renderScale) * 0.1f,
+        _settings.MinRenderScale,
+        std::max(_settings.MaxRenderScale, _settings.MinRenderScale));
+}
+
+float FramePacer::GetFramePeriodMilliseconds() const
+{
+    switch (_settings.Vsync)
+    {
+        case VsyncMode::Off:
+            return _settings.TargetFrameMilliseconds;
+        case VsyncMode::Half:
+            return _statistics.RefreshMilliseconds * 2.0f;
+        default:
+            return _statistics.RefreshMilliseconds;
+    }
+}
+
+void FramePacer::WaitUntil(Clock::time_point time)
+{
+    // sleeping overshoots by up to a scheduler tick, so the last stretch yields instead
+    constexpr auto spinTime = std::chrono::milliseconds(2);
+    if (time - Clock::now() > spinTime)
+    {
+        std::this_thread::sleep_until(time - spinTime);
+    }
+    while (Clock::now() < time)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,114 @@
+#include <Project.Library/GLStateCache.hpp>
+
+#include <glad/glad.h>
+
+GLStateCache::GLStateCache()
+{
+    Invalidate();
+}
+
+void GLStateCache::BeginFrame()
+{
+    Invalidate();
+    _statistics = {};
+}
+
+void GLStateCache::Invalidate()
+{
+    _program = Unknown;
+    _vertexArray = Unknown;
+    _textures.fill(Unknown);
+    _storageBuffers.fill(Unknown);
+    _uniformBuffers.fill(Unknown);
+    _drawIndirectBuffer = Unknown;
+    _dispatchIndirectBuffer = Unknown;
+}
+
+void GLStateCache::UseProgram(uint32_t program)
+{
+    if (Update(GLStateType::Program, _program, program))
+    {
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::BindVertexArray(uint32_t vertexArray)
+{
+    if (Update(GLStateType::VertexArray, _vertexArray, vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void GLStateCache::BindTextureUnit(uint32_t unit, uint32_t texture)
+{
+    if (unit >= MaxTextureUnits)
+    {
+        _statistics.Issued[static_cast<size_t>(GLStateType::Texture)]++;
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+
+    if (Update(GLStateType::Texture, _textures[unit], texture))
+    {
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void GLStateCache::BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer)
+{
+    auto* bindings = target == GL_SHADER_STORAGE_BUFFER
+        ? &_storageBuffers
+        : target == GL_UNIFORM_BUFFER
+            ? &_uniformBuffers
+            : nullptr;
+    if (bindings == nullptr || index >= MaxBufferBindings)
+    {
+        _statistics.Issued[static_cast<size_t>(GLStateType::BufferBase)]++;
+        glBindBufferBase(target, index, buffer);
+        return;
+    }
+
+    if (Update(GLStateType::BufferBase, (*bindings)[index], buffer))
+    {
+        glBindBufferBase(target, index, buffer);
+    }
+}
+
+void GLStateCache::BindBuffer(uint32_t target, uint32_t buffer)
+{
+    auto* binding = target == GL_DRAW_INDIRECT_BUFFER
+        ? &_drawIndirectBuffer
+        : target == GL_DISPATCH_INDIRECT_BUFFER
+            ? &_dispatchIndirectBuffer
+            : nullptr;
+    if (binding == nullptr)
+    {
+        _statistics.Issued[static_cast<size_t>(GLStateType::Buffer)]++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (Update(GLStateType::Buffer, *binding, buffer))
+    {
+        glBindBuffer(target, buffer);
+    }
+}
+
+const GLStateCacheStatistics& GLStateCache::GetStatistics() const
+{
+    return _statistics;
+}
+
+bool GLStateCache::Update(GLStateType type, uint32_t& current, uint32_t value)
+{
+    if (current == value)
+    {
+        _statistics.Skipped[static_cast<size_t>(type)]++;
+        return false;
+    }
+
+    current = value;
+    _statistics.Issued[static_cast<size_t>(type)]++;
+    return true;
+}
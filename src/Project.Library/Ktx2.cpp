@@ -0,0 +1,370 @@
+#include <Project.Library/Ktx2.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+// GL internal formats by value, so reading and writing KTX2 files needs no GL loader.
+// S3TC and ASTC are extensions, the loader generated for core 4.6 does not know them anyway
+constexpr uint32_t GLRgba8 = 0x8058;
+constexpr uint32_t GLSrgb8Alpha8 = 0x8C43;
+constexpr uint32_t GLCompressedRedRgtc1 = 0x8DBB;
+constexpr uint32_t GLCompressedSignedRedRgtc1 = 0x8DBC;
+constexpr uint32_t GLCompressedRgRgtc2 = 0x8DBD;
+constexpr uint32_t GLCompressedSignedRgRgtc2 = 0x8DBE;
+constexpr uint32_t GLCompressedRgbaBptcUnorm = 0x8E8C;
+constexpr uint32_t GLCompressedSrgbAlphaBptcUnorm = 0x8E8D;
+constexpr uint32_t GLCompressedRgbBptcSignedFloat = 0x8E8E;
+constexpr uint32_t GLCompressedRgbBptcUnsignedFloat = 0x8E8F;
+constexpr uint32_t GLCompressedRgbS3tcDxt1 = 0x83F0;
+constexpr uint32_t GLCompressedRgbaS3tcDxt1 = 0x83F1;
+constexpr uint32_t GLCompressedRgbaS3tcDxt3 = 0x83F2;
+constexpr uint32_t GLCompressedRgbaS3tcDxt5 = 0x83F3;
+constexpr uint32_t GLCompressedSrgbS3tcDxt1 = 0x8C4C;
+constexpr uint32_t GLCompressedSrgbAlphaS3tcDxt1 = 0x8C4D;
+constexpr uint32_t GLCompressedSrgbAlphaS3tcDxt3 = 0x8C4E;
+constexpr uint32_t GLCompressedSrgbAlphaS3tcDxt5 = 0x8C4F;
+constexpr uint32_t GLCompressedRgbaAstc4x4 = 0x93B0;
+constexpr uint32_t GLCompressedSrgb8Alpha8Astc4x4 = 0x93D0;
+
+constexpr std::array Ktx2Formats =
+{
+    Ktx2FormatInfo{ Ktx2Format::R8G8B8A8Unorm, GLRgba8, 1, 1, 4, false },
+    Ktx2FormatInfo{ Ktx2Format::R8G8B8A8Srgb, GLSrgb8Alpha8, 1, 1, 4, false },
+    Ktx2FormatInfo{ Ktx2Format::Bc1RgbUnorm, GLCompressedRgbS3tcDxt1, 4, 4, 8, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc1RgbSrgb, GLCompressedSrgbS3tcDxt1, 4, 4, 8, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc1RgbaUnorm, GLCompressedRgbaS3tcDxt1, 4, 4, 8, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc1RgbaSrgb, GLCompressedSrgbAlphaS3tcDxt1, 4, 4, 8, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc2Unorm, GLCompressedRgbaS3tcDxt3, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc2Srgb, GLCompressedSrgbAlphaS3tcDxt3, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc3Unorm, GLCompressedRgbaS3tcDxt5, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc3Srgb, GLCompressedSrgbAlphaS3tcDxt5, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc4Unorm, GLCompressedRedRgtc1, 4, 4, 8, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc4Snorm, GLCompressedSignedRedRgtc1, 4, 4, 8, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc5Unorm, GLCompressedRgRgtc2, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc5Snorm, GLCompressedSignedRgRgtc2, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc6hUfloat, GLCompressedRgbBptcUnsignedFloat, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc6hSfloat, GLCompressedRgbBptcSignedFloat, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc7Unorm, GLCompressedRgbaBptcUnorm, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Bc7Srgb, GLCompressedSrgbAlphaBptcUnorm, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Astc4x4Unorm, GLCompressedRgbaAstc4x4, 4, 4, 16, true },
+    Ktx2FormatInfo{ Ktx2Format::Astc4x4Srgb, GLCompressedSrgb8Alpha8Astc4x4, 4, 4, 16, true },
+};
+
+constexpr std::array<uint8_t, 12> Ktx2Identifier = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct Ktx2Header
+{
+    std::array<uint8_t, 12> Identifier;
+    uint32_t VkFormat;
+    uint32_t TypeSize;
+    uint32_t PixelWidth;
+    uint32_t PixelHeight;
+    uint32_t PixelDepth;
+    uint32_t LayerCount;
+    uint32_t FaceCount;
+    uint32_t LevelCount;
+    uint32_t SupercompressionScheme;
+    uint32_t DfdByteOffset;
+    uint32_t DfdByteLength;
+    uint32_t KvdByteOffset;
+    uint32_t KvdByteLength;
+    uint64_t SgdByteOffset;
+    uint64_t SgdByteLength;
+};
+static_assert(sizeof(Ktx2Header) == 80);
+
+struct Ktx2LevelIndex
+{
+    uint64_t ByteOffset;
+    uint64_t ByteLength;
+    uint64_t UncompressedByteLength;
+};
+static_assert(sizeof(Ktx2LevelIndex) == 24);
+
+const Ktx2FormatInfo* GetKtx2FormatInfo(Ktx2Format format)
+{
+    const auto formatInfo = std::find_if(Ktx2Formats.begin(), Ktx2Formats.end(), [format](const Ktx2FormatInfo& info)
+    {
+        return info.Format == format;
+    });
+    return formatInfo != Ktx2Formats.end() ? &*formatInfo : nullptr;
+}
+
+size_t GetKtx2LevelSize(const Ktx2FormatInfo& formatInfo, uint32_t width, uint32_t height)
+{
+    const auto blocksX = (width + formatInfo.BlockWidth - 1) / formatInfo.BlockWidth;
+    const auto blocksY = (height + formatInfo.BlockHeight - 1) / formatInfo.BlockHeight;
+    return static_cast<size_t>(blocksX) * blocksY * formatInfo.BlockBytes;
+}
+
+bool ReadKtx2(std::span<const uint8_t> file, Ktx2Image& image)
+{
+    Ktx2Header header;
+    if (file.size() < sizeof(header))
+    {
+        spdlog::error("Ktx2: File is too small for a header");
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.Identifier != Ktx2Identifier)
+    {
+        spdlog::error("Ktx2: Not a KTX2 file");
+        return false;
+    }
+    if (header.PixelWidth == 0 || header.PixelHeight == 0 || header.PixelDepth > 1 || header.LayerCount > 1 || header.FaceCount != 1)
+    {
+        spdlog::error("Ktx2: Only single 2D images are supported");
+        return false;
+    }
+    if (header.SupercompressionScheme != 0)
+    {
+        spdlog::error("Ktx2: Supercompression scheme {} is not supported", header.SupercompressionScheme);
+        return false;
+    }
+
+    const auto* formatInfo = GetKtx2FormatInfo(static_cast<Ktx2Format>(header.VkFormat));
+    if (formatInfo == nullptr)
+    {
+        spdlog::error("Ktx2: VkFormat {} is not supported", header.VkFormat);
+        return false;
+    }
+
+    // 0 asks the loader to generate the mip chain, compressed formats can't have that
+    const auto levelCount = std::max(header.LevelCount, 1u);
+    const auto maxLevelCount = static_cast<uint32_t>(std::bit_width(std::max(header.PixelWidth, header.PixelHeight)));
+    if (levelCount > maxLevelCount || sizeof(header) + levelCount * sizeof(Ktx2LevelIndex) > file.size())
+    {
+        spdlog::error("Ktx2: Invalid level count {}", header.LevelCount);
+        return false;
+    }
+
+    image.FormatInfo = *formatInfo;
+    image.Width = header.PixelWidth;
+    image.Height = header.PixelHeight;
+    image.Levels.resize(levelCount);
+    image.Data.clear();
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        Ktx2LevelIndex levelIndex;
+        std::memcpy(&levelIndex, file.data() + sizeof(header) + level * sizeof(Ktx2LevelIndex), sizeof(levelIndex));
+
+        auto& imageLevel = image.Levels[level];
+        imageLevel.Width = std::max(header.PixelWidth >> level, 1u);
+        imageLevel.Height = std::max(header.PixelHeight >> level, 1u);
+        imageLevel.Size = GetKtx2LevelSize(*formatInfo, imageLevel.Width, imageLevel.Height);
+        imageLevel.Offset = image.Data.size();
+        if (levelIndex.ByteLength != imageLevel.Size ||
+            levelIndex.ByteOffset > file.size() ||
+            levelIndex.ByteLength > file.size() - levelIndex.ByteOffset)
+        {
+            spdlog::error("Ktx2: Level {} is out of bounds or has the wrong size", level);
+            return false;
+        }
+        image.Data.insert(
+            image.Data.end(),
+            file.begin() + static_cast<ptrdiff_t>(levelIndex.ByteOffset),
+            file.begin() + static_cast<ptrdiff_t>(levelIndex.ByteOffset + levelIndex.ByteLength));
+    }
+
+    return true;
+}
+
+bool LoadKtx2(std::string_view filePath, Ktx2Image& image)
+{
+    std::ifstream file(filePath.data(), std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        spdlog::error("Ktx2: Unable to open {}", filePath);
+        return false;
+    }
+
+    std::vector<uint8_t> contents(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+    if (!ReadKtx2(contents, image))
+    {
+        spdlog::error("Ktx2: Unable to read {}", filePath);
+        return false;
+    }
+    return true;
+}
+
+// Khronos basic data format descriptor, the loader above never looks at it
+static std::vector<uint8_t> MakeDataFormatDescriptor(const Ktx2FormatInfo& formatInfo)
+{
+    // KHR_DF_MODEL_*, KHR_DF_CHANNEL_* and KHR_DF_SAMPLE_DATATYPE_* values
+    constexpr uint8_t modelRgbsda = 1;
+    constexpr uint8_t modelBc1a = 128;
+    constexpr uint8_t modelBc2 = 129;
+    constexpr uint8_t modelBc3 = 130;
+    constexpr uint8_t modelBc4 = 131;
+    constexpr uint8_t modelBc5 = 132;
+    constexpr uint8_t modelBc6h = 133;
+    constexpr uint8_t modelBc7 = 134;
+    constexpr uint8_t modelAstc = 162;
+    constexpr uint8_t channelColor = 0;
+    constexpr uint8_t channelGreen = 1;
+    constexpr uint8_t channelBlue = 2;
+    constexpr uint8_t channelAlpha = 15;
+    constexpr uint8_t channelBc1AlphaPresent = 1;
+    constexpr uint8_t qualifierSigned = 0x40;
+    constexpr uint8_t qualifierFloat = 0x80;
+
+    struct Sample
+    {
+        uint16_t BitOffset;
+        uint8_t BitLength;
+        uint8_t Channel;
+    };
+
+    auto model = modelRgbsda;
+    std::vector<Sample> samples;
+    uint8_t qualifiers = 0;
+    auto isSrgb = false;
+    switch (formatInfo.Format)
+    {
+        case Ktx2Format::R8G8B8A8Srgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::R8G8B8A8Unorm:
+            samples = { { 0, 8, channelColor }, { 8, 8, channelGreen }, { 16, 8, channelBlue }, { 24, 8, channelAlpha } };
+            break;
+        case Ktx2Format::Bc1RgbSrgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::Bc1RgbUnorm: model = modelBc1a; samples = { { 0, 64, channelColor } }; break;
+        case Ktx2Format::Bc1RgbaSrgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::Bc1RgbaUnorm: model = modelBc1a; samples = { { 0, 64, channelBc1AlphaPresent } }; break;
+        case Ktx2Format::Bc2Srgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::Bc2Unorm: model = modelBc2; samples = { { 0, 64, channelAlpha }, { 64, 64, channelColor } }; break;
+        case Ktx2Format::Bc3Srgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::Bc3Unorm: model = modelBc3; samples = { { 0, 64, channelAlpha }, { 64, 64, channelColor } }; break;
+        case Ktx2Format::Bc4Snorm: qualifiers = qualifierSigned; [[fallthrough]];
+        case Ktx2Format::Bc4Unorm: model = modelBc4; samples = { { 0, 64, channelColor } }; break;
+        case Ktx2Format::Bc5Snorm: qualifiers = qualifierSigned; [[fallthrough]];
+        case Ktx2Format::Bc5Unorm: model = modelBc5; samples = { { 0, 64, channelColor }, { 64, 64, channelGreen } }; break;
+        case Ktx2Format::Bc6hSfloat: qualifiers = qualifierSigned; [[fallthrough]];
+        case Ktx2Format::Bc6hUfloat: model = modelBc6h; qualifiers |= qualifierFloat; samples = { { 0, 128, channelColor } }; break;
+        case Ktx2Format::Bc7Srgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::Bc7Unorm: model = modelBc7; samples = { { 0, 128, channelColor } }; break;
+        case Ktx2Format::Astc4x4Srgb: isSrgb = true; [[fallthrough]];
+        case Ktx2Format::Astc4x4Unorm: model = modelAstc; samples = { { 0, 128, channelColor } }; break;
+        default: break;
+    }
+
+    const auto blockSize = static_cast<uint32_t>(24 + 16 * samples.size());
+    std::vector<uint32_t> words;
+    words.push_back(4 + blockSize);
+    // vendor Khronos and descriptor type basic are both 0
+    words.push_back(0);
+    // version 1.3
+    words.push_back(2 | blockSize << 16);
+    // model, BT.709 primaries, linear or sRGB transfer, straight alpha
+    words.push_back(model | 1u << 8 | (isSrgb ? 2u : 1u) << 16);
+    words.push_back((formatInfo.BlockWidth - 1) | (formatInfo.BlockHeight - 1) << 8);
+    words.push_back(formatInfo.BlockBytes);
+    words.push_back(0);
+    for (const auto& sample : samples)
+    {
+        const auto channel = static_cast<uint32_t>(sample.Channel | (model == modelRgbsda ? 0 : qualifiers));
+        words.push_back(sample.BitOffset | static_cast<uint32_t>(sample.BitLength - 1) << 16 | channel << 24);
+        words.push_back(0);
+        const auto isSigned = (qualifiers & qualifierSigned) != 0;
+        if ((qualifiers & qualifierFloat) != 0)
+        {
+            words.push_back(isSigned ? std::bit_cast<uint32_t>(-1.0f) : 0);
+            words.push_back(std::bit_cast<uint32_t>(1.0f));
+        }
+        else if (model == modelRgbsda)
+        {
+            words.push_back(0);
+            words.push_back(255);
+        }
+        else
+        {
+            words.push_back(isSigned ? 0x80000000u : 0u);
+            words.push_back(isSigned ? 0x7FFFFFFFu : UINT32_MAX);
+        }
+    }
+
+    std::vector<uint8_t> bytes(words.size() * sizeof(uint32_t));
+    std::memcpy(bytes.data(), words.data(), bytes.size());
+    return bytes;
+}
+
+bool WriteKtx2(const Ktx2Image& image, std::vector<uint8_t>& file)
+{
+    const auto levelCount = static_cast<uint32_t>(image.Levels.size());
+    if (levelCount == 0 || image.FormatInfo.Format == Ktx2Format::Undefined)
+    {
+        spdlog::error("Ktx2: Nothing to write");
+        return false;
+    }
+
+    const auto dataFormatDescriptor = MakeDataFormatDescriptor(image.FormatInfo);
+    constexpr std::string_view writerKey = "KTXwriter";
+    constexpr std::string_view writerValue = "Project.TextureCompressor";
+    // length, then key and value, both null terminated, padded to 4 bytes
+    const auto keyValueLength = static_cast<uint32_t>(writerKey.size() + 1 + writerValue.size() + 1);
+    std::vector<uint8_t> keyValueData((sizeof(keyValueLength) + keyValueLength + 3) & ~size_t(3), 0);
+    std::memcpy(keyValueData.data(), &keyValueLength, sizeof(keyValueLength));
+    std::memcpy(keyValueData.data() + sizeof(keyValueLength), writerKey.data(), writerKey.size());
+    std::memcpy(keyValueData.data() + sizeof(keyValueLength) + writerKey.size() + 1, writerValue.data(), writerValue.size());
+
+    Ktx2Header header = {};
+    header.Identifier = Ktx2Identifier;
+    header.VkFormat = static_cast<uint32_t>(image.FormatInfo.Format);
+    // 1 for block compressed and 8 bit formats alike
+    header.TypeSize = 1;
+    header.PixelWidth = image.Width;
+    header.PixelHeight = image.Height;
+    header.FaceCount = 1;
+    header.LevelCount = levelCount;
+    header.DfdByteOffset = static_cast<uint32_t>(sizeof(header) + levelCount * sizeof(Ktx2LevelIndex));
+    header.DfdByteLength = static_cast<uint32_t>(dataFormatDescriptor.size());
+    header.KvdByteOffset = header.DfdByteOffset + header.DfdByteLength;
+    header.KvdByteLength = static_cast<uint32_t>(keyValueData.size());
+
+    // the spec wants the smallest level first, every one aligned to lcm(block size, 4)
+    const auto alignment = std::lcm<size_t>(image.FormatInfo.BlockBytes, 4);
+    std::vector<Ktx2LevelIndex> levelIndices(levelCount);
+    auto offset = static_cast<size_t>(header.KvdByteOffset) + header.KvdByteLength;
+    for (auto level = levelCount; level-- > 0;)
+    {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelIndices[level] = { offset, image.Levels[level].Size, image.Levels[level].Size };
+        offset += image.Levels[level].Size;
+    }
+
+    file.assign(offset, 0);
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), levelIndices.data(), levelIndices.size() * sizeof(Ktx2LevelIndex));
+    std::memcpy(file.data() + header.DfdByteOffset, dataFormatDescriptor.data(), dataFormatDescriptor.size());
+    std::memcpy(file.data() + header.KvdByteOffset, keyValueData.data(), keyValueData.size());
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        const auto& imageLevel = image.Levels[level];
+        std::memcpy(file.data() + levelIndices[level].ByteOffset, image.Data.data() + imageLevel.Offset, imageLevel.Size);
+    }
+    return true;
+}
+
+bool SaveKtx2(std::string_view filePath, const Ktx2Image& image)
+{
+    std::vector<uint8_t> file;
+    if (!WriteKtx2(image, file))
+    {
+        spdlog::error("Ktx2: Unable to write {}", filePath);
+        return false;
+    }
+
+    std::ofstream output(filePath.data(), std::ios::binary);
+    if (!output.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size())))
+    {
+        spdlog::error("Ktx2: Unable to write {}", filePath);
+        return false;
+    }
+    return true;
+}
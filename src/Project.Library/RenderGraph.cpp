@@ -0,0 +1,339 @@
+#include <Project.Library/RenderGraph.hpp>
+
+#include <spdlog/spdlog.h>
+#include <glad/glad.h>
+
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+
+static GLbitfield ToMemoryBarrierBits(RenderGraphAccess access)
+{
+    GLbitfield bits = 0;
+    const auto has = [access](RenderGraphAccess bit) { return (access & bit) != RenderGraphAccess::None; };
+    if (has(RenderGraphAccess::TextureFetch)) bits |= GL_TEXTURE_FETCH_BARRIER_BIT;
+    if (has(RenderGraphAccess::ImageLoadStore)) bits |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    if (has(RenderGraphAccess::StorageBuffer)) bits |= GL_SHADER_STORAGE_BARRIER_BIT;
+    if (has(RenderGraphAccess::UniformBuffer)) bits |= GL_UNIFORM_BARRIER_BIT;
+    if (has(RenderGraphAccess::IndirectCommand)) bits |= GL_COMMAND_BARRIER_BIT;
+    if (has(RenderGraphAccess::VertexAttribute)) bits |= GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+    if (has(RenderGraphAccess::ElementArray)) bits |= GL_ELEMENT_ARRAY_BARRIER_BIT;
+    if (has(RenderGraphAccess::Framebuffer)) bits |= GL_FRAMEBUFFER_BARRIER_BIT;
+    if (has(RenderGraphAccess::BufferUpdate)) bits |= GL_BUFFER_UPDATE_BARRIER_BIT;
+    if (has(RenderGraphAccess::TextureUpdate)) bits |= GL_TEXTURE_UPDATE_BARRIER_BIT;
+    if (has(RenderGraphAccess::PixelBuffer)) bits |= GL_PIXEL_BUFFER_BARRIER_BIT;
+    return bits;
+}
+
+void RenderGraph::Reset()
+{
+    _passes.clear();
+    _resources.clear();
+    _versions.clear();
+    _executionOrder.clear();
+    _physicalSlots.clear();
+    _stats = {};
+    _hasErrors = false;
+    _isCompiled = false;
+}
+
+void RenderGraph::Release()
+{
+    for (const auto& pooled : _pool)
+    {
+        if (pooled.Type == RenderGraphResourceType::Texture)
+        {
+            glDeleteTextures(1, &pooled.Handle);
+        }
+        else
+        {
+            glDeleteBuffers(1, &pooled.Handle);
+        }
+    }
+    _pool.clear();
+    Reset();
+}
+
+RenderGraphResource RenderGraph::CreateTexture(std::string_view name, const RenderGraphTextureDesc& desc)
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Type = RenderGraphResourceType::Texture;
+    resource.TextureDesc = desc;
+    return AddResource(std::move(resource));
+}
+
+RenderGraphResource RenderGraph::CreateBuffer(std::string_view name, const RenderGraphBufferDesc& desc)
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Type = RenderGraphResourceType::Buffer;
+    resource.BufferDesc = desc;
+    return AddResource(std::move(resource));
+}
+
+RenderGraphResource RenderGraph::ImportTexture(std::string_view name, uint32_t texture, const RenderGraphTextureDesc& desc)
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Type = RenderGraphResourceType::Texture;
+    resource.TextureDesc = desc;
+    resource.IsImported = true;
+    resource.ImportedHandle = texture;
+    return AddResource(std::move(resource));
+}
+
+RenderGraphResource RenderGraph::ImportBuffer(std::string_view name, uint32_t buffer, const RenderGraphBufferDesc& desc)
+{
+    Resource resource;
+    resource.Name = name;
+    resource.Type = RenderGraphResourceType::Buffer;
+    resource.BufferDesc = desc;
+    resource.IsImported = true;
+    resource.ImportedHandle = buffer;
+    return AddResource(std::move(resource));
+}
+
+RenderGraphResource RenderGraph::AddResource(Resource resource)
+{
+    const auto version = static_cast<RenderGraphResource>(_versions.size());
+    resource.LatestVersion = version;
+    _resources.emplace_back(std::move(resource));
+    _versions.emplace_back(ResourceVersion{ static_cast<uint32_t>(_resources.size() - 1) });
+    return version;
+}
+
+void RenderGraph::AddPass(std::string_view name, const SetupFunction& setup, ExecuteFunction execute)
+{
+    auto& pass = _passes.emplace_back();
+    pass.Name = name;
+    pass.Execute = std::move(execute);
+
+    RenderGraphBuilder builder(*this, static_cast<uint32_t>(_passes.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::Execute()
+{
+    ZoneScopedN("RenderGraph Execute");
+
+    if (!_isCompiled)
+    {
+        spdlog::error("RenderGraph: Execute called without a successful Compile");
+        return;
+    }
+
+    AcquirePhysicalResources();
+
+    RenderGraphContext context(*this);
+    for (const auto passIndex : _executionOrder)
+    {
+        auto& pass = _passes[passIndex];
+        ZoneScopedN("RenderGraph Pass");
+        ZoneName(pass.Name.data(), pass.Name.size());
+
+        if (pass.Barrier != RenderGraphAccess::None)
+        {
+            glMemoryBarrier(ToMemoryBarrierBits(pass.Barrier));
+        }
+        if (pass.Execute)
+        {
+            pass.Execute(context);
+        }
+    }
+
+    ReleaseUnusedPhysicalResources();
+    _frameIndex++;
+}
+
+const RenderGraphStats& RenderGraph::GetStats() const
+{
+    return _stats;
+}
+
+std::vector<std::string_view> RenderGraph::GetPassOrder() const
+{
+    std::vector<std::string_view> names;
+    names.reserve(_executionOrder.size());
+    for (const auto passIndex : _executionOrder)
+    {
+        names.emplace_back(_passes[passIndex].Name);
+    }
+    return names;
+}
+
+uint32_t RenderGraph::GetPhysicalSlot(RenderGraphResource resource) const
+{
+    return resource < _versions.size()
+        ? _resources[_versions[resource].Resource].PhysicalSlot
+        : InvalidRenderGraphResource;
+}
+
+RenderGraphAccess RenderGraph::GetBarrierBeforePass(std::string_view name) const
+{
+    for (const auto& pass : _passes)
+    {
+        if (pass.Name == name)
+        {
+            return pass.Barrier;
+        }
+    }
+    return RenderGraphAccess::None;
+}
+
+void RenderGraph::AcquirePhysicalResources()
+{
+    for (auto& pooled : _pool)
+    {
+        pooled.IsInUse = false;
+    }
+
+    for (auto& slot : _physicalSlots)
+    {
+        auto pooled = std::find_if(_pool.begin(), _pool.end(), [&slot](const PooledResource& candidate)
+        {
+            if (candidate.IsInUse || candidate.Type != slot.Type)
+            {
+                return false;
+            }
+            return slot.Type == RenderGraphResourceType::Texture
+                ? candidate.TextureDesc == slot.TextureDesc
+                : candidate.BufferDesc.Size >= slot.BufferDesc.Size;
+        });
+
+        if (pooled == _pool.end())
+        {
+            auto& created = _pool.emplace_back();
+            created.Type = slot.Type;
+            created.TextureDesc = slot.TextureDesc;
+            created.BufferDesc = slot.BufferDesc;
+            if (slot.Type == RenderGraphResourceType::Texture)
+            {
+                glCreateTextures(GL_TEXTURE_2D, 1, &created.Handle);
+                glTextureParameteri(created.Handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTextureParameteri(created.Handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTextureParameteri(created.Handle, GL_TEXTURE_MIN_FILTER, slot.TextureDesc.Levels > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR);
+                glTextureParameteri(created.Handle, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTextureStorage2D(
+                    created.Handle,
+                    std::max(slot.TextureDesc.Levels, 1u),
+                    slot.TextureDesc.Format,
+                    slot.TextureDesc.Width,
+                    slot.TextureDesc.Height);
+            }
+            else
+            {
+                glCreateBuffers(1, &created.Handle);
+                glNamedBufferStorage(created.Handle, slot.BufferDesc.Size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+            }
+            pooled = std::prev(_pool.end());
+        }
+
+        pooled->IsInUse = true;
+        pooled->LastUsedFrame = _frameIndex;
+        slot.Handle = pooled->Handle;
+    }
+}
+
+void RenderGraph::ReleaseUnusedPhysicalResources()
+{
+    // Keep them around for a couple of frames, passes toggled on and off or
+    // a window being resized would otherwise recreate them every frame
+    constexpr uint64_t framesToKeep = 3;
+    std::erase_if(_pool, [this](const PooledResource& pooled)
+    {
+        if (pooled.IsInUse || pooled.LastUsedFrame + framesToKeep > _frameIndex)
+        {
+            return false;
+        }
+        if (pooled.Type == RenderGraphResourceType::Texture)
+        {
+            glDeleteTextures(1, &pooled.Handle);
+        }
+        else
+        {
+            glDeleteBuffers(1, &pooled.Handle);
+        }
+        return true;
+    });
+}
+
+RenderGraphBuilder::RenderGraphBuilder(RenderGraph& graph, uint32_t passIndex)
+    : _graph(graph), _passIndex(passIndex)
+{
+}
+
+void RenderGraphBuilder::Read(RenderGraphResource resource, RenderGraphAccess access)
+{
+    auto& pass = _graph._passes[_passIndex];
+    if (resource >= _graph._versions.size())
+    {
+        spdlog::error("RenderGraph: Pass {} reads an unknown resource {}", pass.Name, resource);
+        _graph._hasErrors = true;
+        return;
+    }
+    pass.Reads.emplace_back(RenderGraph::ResourceAccess{ resource, access });
+}
+
+RenderGraphResource RenderGraphBuilder::Write(RenderGraphResource resource, RenderGraphAccess access)
+{
+    auto& pass = _graph._passes[_passIndex];
+    if (resource >= _graph._versions.size())
+    {
+        spdlog::error("RenderGraph: Pass {} writes an unknown resource {}", pass.Name, resource);
+        _graph._hasErrors = true;
+        return InvalidRenderGraphResource;
+    }
+
+    const auto resourceIndex = _graph._versions[resource].Resource;
+    auto& graphResource = _graph._resources[resourceIndex];
+    if (graphResource.LatestVersion != resource)
+    {
+        spdlog::error("RenderGraph: Pass {} writes an outdated version of {}", pass.Name, graphResource.Name);
+        _graph._hasErrors = true;
+        return InvalidRenderGraphResource;
+    }
+
+    const auto version = static_cast<RenderGraphResource>(_graph._versions.size());
+    _graph._versions.emplace_back(RenderGraph::ResourceVersion{ resourceIndex, _passIndex, resource });
+    graphResource.LatestVersion = version;
+    pass.Writes.emplace_back(RenderGraph::ResourceAccess{ version, access });
+    return version;
+}
+
+void RenderGraphBuilder::HasSideEffects()
+{
+    _graph._passes[_passIndex].HasSideEffects = true;
+}
+
+RenderGraphContext::RenderGraphContext(const RenderGraph& graph)
+    : _graph(graph)
+{
+}
+
+uint32_t RenderGraphContext::GetTexture(RenderGraphResource resource) const
+{
+    return GetHandle(resource);
+}
+
+uint32_t RenderGraphContext::GetBuffer(RenderGraphResource resource) const
+{
+    return GetHandle(resource);
+}
+
+const RenderGraphTextureDesc& RenderGraphContext::GetTextureDesc(RenderGraphResource resource) const
+{
+    return _graph._resources[_graph._versions[resource].Resource].TextureDesc;
+}
+
+uint32_t RenderGraphContext::GetHandle(RenderGraphResource resource) const
+{
+    const auto& graphResource = _graph._resources[_graph._versions[resource].Resource];
+    if (graphResource.IsImported)
+    {
+        return graphResource.ImportedHandle;
+    }
+    return graphResource.PhysicalSlot != InvalidRenderGraphResource
+        ? _graph._physicalSlots[graphResource.PhysicalSlot].Handle
+        : 0;
+}
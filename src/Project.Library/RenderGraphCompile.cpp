@@ -0,0 +1,379 @@
+#include <Project.Library/RenderGraph.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+// GL internal formats by value, Compile and its helpers stay free of GL so they can run without a context
+constexpr uint32_t GLR8 = 0x8229;
+constexpr uint32_t GLRg8 = 0x822B;
+constexpr uint32_t GLR16f = 0x822D;
+constexpr uint32_t GLDepthComponent16 = 0x81A5;
+constexpr uint32_t GLRgba8 = 0x8058;
+constexpr uint32_t GLSrgb8Alpha8 = 0x8C43;
+constexpr uint32_t GLRg16f = 0x822F;
+constexpr uint32_t GLR32f = 0x822E;
+constexpr uint32_t GLR32ui = 0x8236;
+constexpr uint32_t GLR11fG11fB10f = 0x8C3A;
+constexpr uint32_t GLRgb10A2 = 0x8059;
+constexpr uint32_t GLDepthComponent24 = 0x81A6;
+constexpr uint32_t GLDepthComponent32f = 0x8CAC;
+constexpr uint32_t GLDepth24Stencil8 = 0x88F0;
+constexpr uint32_t GLRgba16f = 0x881A;
+constexpr uint32_t GLRg32f = 0x8230;
+constexpr uint32_t GLDepth32fStencil8 = 0x8CAD;
+constexpr uint32_t GLRgba32f = 0x8814;
+
+static uint32_t GetBytesPerPixel(uint32_t format)
+{
+    switch (format)
+    {
+        case GLR8:
+            return 1;
+        case GLRg8:
+        case GLR16f:
+        case GLDepthComponent16:
+            return 2;
+        case GLRgba8:
+        case GLSrgb8Alpha8:
+        case GLRg16f:
+        case GLR32f:
+        case GLR32ui:
+        case GLR11fG11fB10f:
+        case GLRgb10A2:
+        case GLDepthComponent24:
+        case GLDepthComponent32f:
+        case GLDepth24Stencil8:
+            return 4;
+        case GLRgba16f:
+        case GLRg32f:
+        case GLDepth32fStencil8:
+            return 8;
+        case GLRgba32f:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+static bool IsIncoherentWrite(RenderGraphAccess access)
+{
+    return (access & (RenderGraphAccess::ImageLoadStore | RenderGraphAccess::StorageBuffer)) != RenderGraphAccess::None;
+}
+
+bool RenderGraph::Compile()
+{
+    ZoneScopedN("RenderGraph Compile");
+
+    // Compiling again without a Reset starts over instead of building on the previous results
+    _isCompiled = false;
+    _stats = {};
+    _stats.DeclaredPasses = static_cast<uint32_t>(_passes.size());
+    _executionOrder.clear();
+    _physicalSlots.clear();
+    for (auto& pass : _passes)
+    {
+        pass.IsAlive = false;
+        pass.Barrier = RenderGraphAccess::None;
+    }
+    for (auto& resource : _resources)
+    {
+        resource.FirstUse = UINT32_MAX;
+        resource.LastUse = 0;
+        resource.PhysicalSlot = InvalidRenderGraphResource;
+    }
+
+    if (_hasErrors || !SortPasses())
+    {
+        return false;
+    }
+
+    CullPasses();
+    ComputeLifetimes();
+    AliasResources();
+    BatchBarriers();
+
+    _isCompiled = true;
+    return true;
+}
+
+size_t RenderGraph::GetTextureSize(const RenderGraphTextureDesc& desc)
+{
+    size_t size = 0;
+    for (uint32_t level = 0; level < std::max(desc.Levels, 1u); ++level)
+    {
+        const size_t width = std::max(desc.Width >> level, 1u);
+        const size_t height = std::max(desc.Height >> level, 1u);
+        size += width * height * GetBytesPerPixel(desc.Format);
+    }
+    return size;
+}
+
+size_t RenderGraph::GetResourceSize(const Resource& resource)
+{
+    return resource.Type == RenderGraphResourceType::Texture
+        ? GetTextureSize(resource.TextureDesc)
+        : resource.BufferDesc.Size;
+}
+
+bool RenderGraph::SortPasses()
+{
+    const auto passCount = _passes.size();
+    std::vector<std::vector<uint32_t>> readers(_versions.size());
+    for (uint32_t passIndex = 0; passIndex < passCount; ++passIndex)
+    {
+        for (const auto& read : _passes[passIndex].Reads)
+        {
+            readers[read.Version].push_back(passIndex);
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> edges(passCount);
+    std::vector<uint32_t> inDegree(passCount, 0);
+    const auto addEdge = [&](uint32_t from, uint32_t to)
+    {
+        if (from != UINT32_MAX && from != to)
+        {
+            edges[from].push_back(to);
+            inDegree[to]++;
+        }
+    };
+
+    for (uint32_t passIndex = 0; passIndex < passCount; ++passIndex)
+    {
+        const auto& pass = _passes[passIndex];
+        for (const auto& read : pass.Reads)
+        {
+            addEdge(_versions[read.Version].Producer, passIndex);
+        }
+        for (const auto& write : pass.Writes)
+        {
+            // writes wait for the previous writer and for everyone still reading the version they replace
+            const auto previous = _versions[write.Version].Previous;
+            addEdge(_versions[previous].Producer, passIndex);
+            for (const auto reader : readers[previous])
+            {
+                addEdge(reader, passIndex);
+            }
+        }
+    }
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+    for (uint32_t passIndex = 0; passIndex < passCount; ++passIndex)
+    {
+        if (inDegree[passIndex] == 0)
+        {
+            ready.push(passIndex);
+        }
+    }
+
+    _executionOrder.clear();
+    _executionOrder.reserve(passCount);
+    while (!ready.empty())
+    {
+        const auto passIndex = ready.top();
+        ready.pop();
+        _executionOrder.push_back(passIndex);
+        for (const auto next : edges[passIndex])
+        {
+            if (--inDegree[next] == 0)
+            {
+                ready.push(next);
+            }
+        }
+    }
+
+    if (_executionOrder.size() != passCount)
+    {
+        spdlog::error("RenderGraph: Passes form a dependency cycle");
+        _executionOrder.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void RenderGraph::CullPasses()
+{
+    std::vector<bool> isNeeded(_versions.size(), false);
+    for (auto it = _executionOrder.rbegin(); it != _executionOrder.rend(); ++it)
+    {
+        auto& pass = _passes[*it];
+        pass.IsAlive = pass.HasSideEffects;
+        for (const auto& write : pass.Writes)
+        {
+            pass.IsAlive |= _resources[_versions[write.Version].Resource].IsImported || isNeeded[write.Version];
+        }
+        if (!pass.IsAlive)
+        {
+            continue;
+        }
+
+        for (const auto& read : pass.Reads)
+        {
+            isNeeded[read.Version] = true;
+        }
+    }
+
+    std::erase_if(_executionOrder, [this](uint32_t passIndex) { return !_passes[passIndex].IsAlive; });
+    _stats.CulledPasses = static_cast<uint32_t>(_passes.size() - _executionOrder.size());
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+    for (uint32_t position = 0; position < _executionOrder.size(); ++position)
+    {
+        const auto& pass = _passes[_executionOrder[position]];
+        for (const auto& accesses : { &pass.Reads, &pass.Writes })
+        {
+            for (const auto& access : *accesses)
+            {
+                auto& resource = _resources[_versions[access.Version].Resource];
+                resource.FirstUse = std::min(resource.FirstUse, position);
+                resource.LastUse = std::max(resource.LastUse, position);
+            }
+        }
+    }
+
+    for (uint32_t position = 0; position < _executionOrder.size(); ++position)
+    {
+        size_t liveMemory = 0;
+        for (const auto& resource : _resources)
+        {
+            if (!resource.IsImported && resource.FirstUse <= position && position <= resource.LastUse)
+            {
+                liveMemory += GetResourceSize(resource);
+            }
+        }
+        _stats.PeakLiveTransientMemory = std::max(_stats.PeakLiveTransientMemory, liveMemory);
+    }
+}
+
+void RenderGraph::AliasResources()
+{
+    std::vector<uint32_t> transients;
+    for (uint32_t index = 0; index < _resources.size(); ++index)
+    {
+        const auto& resource = _resources[index];
+        if (!resource.IsImported && resource.FirstUse != UINT32_MAX)
+        {
+            transients.push_back(index);
+        }
+    }
+
+    // Place resources by first use and larger ones first, later ones fill the gaps left behind
+    std::stable_sort(transients.begin(), transients.end(), [this](uint32_t lhs, uint32_t rhs)
+    {
+        const auto& left = _resources[lhs];
+        const auto& right = _resources[rhs];
+        if (left.FirstUse != right.FirstUse)
+        {
+            return left.FirstUse < right.FirstUse;
+        }
+        return GetResourceSize(left) > GetResourceSize(right);
+    });
+
+    for (const auto index : transients)
+    {
+        auto& resource = _resources[index];
+        _stats.TransientResources++;
+        _stats.TransientMemoryWithoutAliasing += GetResourceSize(resource);
+
+        for (uint32_t slotIndex = 0; slotIndex < _physicalSlots.size(); ++slotIndex)
+        {
+            auto& slot = _physicalSlots[slotIndex];
+            const auto isCompatible = slot.Type == resource.Type &&
+                (slot.Type == RenderGraphResourceType::Buffer || slot.TextureDesc == resource.TextureDesc);
+            if (isCompatible && slot.LastUse < resource.FirstUse)
+            {
+                slot.LastUse = resource.LastUse;
+                slot.BufferDesc.Size = std::max(slot.BufferDesc.Size, resource.BufferDesc.Size);
+                resource.PhysicalSlot = slotIndex;
+                break;
+            }
+        }
+
+        if (resource.PhysicalSlot == InvalidRenderGraphResource)
+        {
+            _physicalSlots.emplace_back(PhysicalSlot
+            {
+                resource.Type,
+                resource.TextureDesc,
+                resource.BufferDesc,
+                resource.LastUse
+            });
+            resource.PhysicalSlot = static_cast<uint32_t>(_physicalSlots.size() - 1);
+        }
+    }
+
+    _stats.PhysicalResources = static_cast<uint32_t>(_physicalSlots.size());
+    for (const auto& slot : _physicalSlots)
+    {
+        _stats.TransientMemoryWithAliasing += slot.Type == RenderGraphResourceType::Texture
+            ? GetTextureSize(slot.TextureDesc)
+            : slot.BufferDesc.Size;
+    }
+}
+
+void RenderGraph::BatchBarriers()
+{
+    // glMemoryBarrier is global, once a bit has been issued every incoherent write
+    // before it is visible to that kind of access, no matter which resource.
+    // Aliased resources share memory, so writes are tracked per physical slot, imported
+    // resources come after the slots
+    const auto physicalSlotCount = _physicalSlots.size();
+    const auto getMemory = [&](uint32_t resource)
+    {
+        const auto physicalSlot = _resources[resource].PhysicalSlot;
+        return physicalSlot != InvalidRenderGraphResource ? physicalSlot : physicalSlotCount + resource;
+    };
+    std::vector<bool> hasPendingWrite(physicalSlotCount + _resources.size(), false);
+    std::vector<RenderGraphAccess> madeVisible(physicalSlotCount + _resources.size(), RenderGraphAccess::None);
+
+    for (const auto passIndex : _executionOrder)
+    {
+        auto& pass = _passes[passIndex];
+        pass.Barrier = RenderGraphAccess::None;
+        for (const auto& accesses : { &pass.Reads, &pass.Writes })
+        {
+            for (const auto& access : *accesses)
+            {
+                const auto memory = getMemory(_versions[access.Version].Resource);
+                if (!hasPendingWrite[memory])
+                {
+                    continue;
+                }
+                const auto missing = static_cast<RenderGraphAccess>(
+                    static_cast<uint32_t>(access.Access) & ~static_cast<uint32_t>(madeVisible[memory]));
+                if (missing != RenderGraphAccess::None)
+                {
+                    pass.Barrier = pass.Barrier | missing;
+                    _stats.UnbatchedBarriers++;
+                }
+            }
+        }
+
+        if (pass.Barrier != RenderGraphAccess::None)
+        {
+            _stats.BatchedBarriers++;
+            for (size_t memory = 0; memory < hasPendingWrite.size(); ++memory)
+            {
+                if (hasPendingWrite[memory])
+                {
+                    madeVisible[memory] = madeVisible[memory] | pass.Barrier;
+                }
+            }
+        }
+
+        for (const auto& write : pass.Writes)
+        {
+            const auto memory = getMemory(_versions[write.Version].Resource);
+            hasPendingWrite[memory] = IsIncoherentWrite(write.Access);
+            madeVisible[memory] = RenderGraphAccess::None;
+        }
+    }
+}
@@ -0,0 +1,494 @@
+#include <Project.Library/SoftwareOcclusionCulling.hpp>
+#include <Project.Library/ThreadPool.hpp>
+
+#include <glm/vec4.hpp>
+
+#include <tracy/Tracy.hpp>
+
+// The AVX2 path is compiled into this function alone and picked at runtime, the rest
+// of the library keeps the baseline instruction set and runs on any x86-64 CPU
+#if defined(PROJECT_ENABLE_AVX2) && (defined(__x86_64__) || defined(_M_X64))
+#define HAS_AVX2_PATH
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// Keeps every edge function product within int32, see the constructor
+constexpr float GuardBand = 256.0f;
+constexpr uint32_t MaxSize = 1024;
+constexpr int32_t SubpixelBits = 4;
+constexpr int32_t SubpixelScale = 1 << SubpixelBits;
+constexpr int32_t HalfPixel = SubpixelScale / 2;
+// Surfaces touching or coinciding with an occluder must not be hidden by interpolation error
+constexpr float DepthTestBias = 1.0e-6f;
+
+static bool IsAvx2Supported()
+{
+#if !defined(HAS_AVX2_PATH)
+    return false;
+#elif defined(_MSC_VER)
+    // AVX2 needs the OS to save the upper halves of the ymm registers as well
+    int32_t info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    const auto hasOsXsave = (info[2] & (1 << 27)) != 0;
+    const auto hasAvx = (info[2] & (1 << 28)) != 0;
+    if (!hasOsXsave || !hasAvx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const bool IsAvx2Available = IsAvx2Supported();
+
+static glm::vec3 GetCorner(const glm::vec3& boundsMin, const glm::vec3& boundsMax, uint32_t corner)
+{
+    return glm::vec3(
+        (corner & 1) ? boundsMax.x : boundsMin.x,
+        (corner & 2) ? boundsMax.y : boundsMin.y,
+        (corner & 4) ? boundsMax.z : boundsMin.z);
+}
+
+// Projects the corners of the bounds, false when they reach behind the near plane
+static bool ProjectBounds(
+    const glm::mat4& worldViewProjection,
+    const glm::vec3& boundsMin,
+    const glm::vec3& boundsMax,
+    glm::vec3& ndcMin,
+    glm::vec3& ndcMax)
+{
+    ndcMin = glm::vec3(std::numeric_limits<float>::max());
+    ndcMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const auto clip = worldViewProjection * glm::vec4(GetCorner(boundsMin, boundsMax, corner), 1.0f);
+        if (clip.w <= std::numeric_limits<float>::epsilon() || clip.z < -clip.w)
+        {
+            return false;
+        }
+        const auto ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    return true;
+}
+
+SoftwareOcclusionCulling::SoftwareOcclusionCulling(uint32_t width, uint32_t height)
+{
+    // With 28.4 coordinates inside the screen plus guard band, edge deltas and pixel
+    // offsets stay below 2^15 and their products below 2^30
+    width = std::clamp(width, TileWidth, MaxSize);
+    height = std::clamp(height, TileHeight, MaxSize);
+    _tilesX = (width + TileWidth - 1) / TileWidth;
+    _tilesY = (height + TileHeight - 1) / TileHeight;
+    _width = _tilesX * TileWidth;
+    _height = _tilesY * TileHeight;
+    _depth.assign(static_cast<size_t>(_width) * _height, 1.0f);
+}
+
+void SoftwareOcclusionCulling::Rasterize(std::span<const OccluderMesh> occluders, ThreadPool& threadPool)
+{
+    ZoneScopedN("Software Occlusion Rasterize");
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const auto threadCount = threadPool.GetThreadCount();
+    const auto tileCount = _tilesX * _tilesY;
+    _threadTriangles.resize(threadCount);
+    _threadBins.resize(threadCount);
+    for (uint32_t thread = 0; thread < threadCount; ++thread)
+    {
+        _threadTriangles[thread].clear();
+        _threadBins[thread].resize(tileCount);
+        for (auto& bin : _threadBins[thread])
+        {
+            bin.clear();
+        }
+    }
+
+    threadPool.ParallelFor(static_cast<uint32_t>(occluders.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+    {
+        auto& triangles = _threadTriangles[threadIndex];
+        auto& bins = _threadBins[threadIndex];
+        for (auto occluder = begin; occluder < end; ++occluder)
+        {
+            const auto firstTriangle = static_cast<uint32_t>(triangles.size());
+            SetupTriangles(occluders[occluder], triangles);
+            for (auto index = firstTriangle; index < triangles.size(); ++index)
+            {
+                const auto& triangle = triangles[index];
+                for (auto tileY = triangle.MinY / TileHeight; tileY <= triangle.MaxY / TileHeight; ++tileY)
+                {
+                    for (auto tileX = triangle.MinX / TileWidth; tileX <= triangle.MaxX / TileWidth; ++tileX)
+                    {
+                        bins[tileY * _tilesX + tileX].push_back(index);
+                    }
+                }
+            }
+        }
+    });
+
+    // Depth only ever takes the minimum, so the order in which bins are walked does not matter
+    threadPool.ParallelFor(tileCount, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+    {
+        for (auto tile = begin; tile < end; ++tile)
+        {
+            const auto tileMinX = static_cast<int32_t>((tile % _tilesX) * TileWidth);
+            const auto tileMinY = static_cast<int32_t>((tile / _tilesX) * TileHeight);
+            const auto tileMaxX = tileMinX + static_cast<int32_t>(TileWidth) - 1;
+            const auto tileMaxY = tileMinY + static_cast<int32_t>(TileHeight) - 1;
+            for (auto y = tileMinY; y <= tileMaxY; ++y)
+            {
+                auto* row = _depth.data() + static_cast<size_t>(y) * _width;
+                std::fill(row + tileMinX, row + tileMaxX + 1, 1.0f);
+            }
+
+            for (uint32_t thread = 0; thread < threadCount; ++thread)
+            {
+                for (const auto index : _threadBins[thread][tile])
+                {
+                    const auto& triangle = _threadTriangles[thread][index];
+                    RasterizeTriangle(
+                        triangle,
+                        std::max(triangle.MinX, tileMinX),
+                        std::max(triangle.MinY, tileMinY),
+                        std::min(triangle.MaxX, tileMaxX),
+                        std::min(triangle.MaxY, tileMaxY));
+                }
+            }
+        }
+    });
+
+    uint32_t rasterizedTriangles = 0;
+    for (const auto& triangles : _threadTriangles)
+    {
+        rasterizedTriangles += static_cast<uint32_t>(triangles.size());
+    }
+
+    const auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime);
+    UpdateStatistics(occluders, rasterizedTriangles, elapsed.count());
+}
+
+void SoftwareOcclusionCulling::RasterizeReference(std::span<const OccluderMesh> occluders)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    std::fill(_depth.begin(), _depth.end(), 1.0f);
+    std::vector<Triangle> triangles;
+    for (const auto& occluder : occluders)
+    {
+        SetupTriangles(occluder, triangles);
+    }
+    for (const auto& triangle : triangles)
+    {
+        RasterizeTriangleScalar(triangle, triangle.MinX, triangle.MinY, triangle.MaxX, triangle.MaxY);
+    }
+
+    const auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime);
+    UpdateStatistics(occluders, static_cast<uint32_t>(triangles.size()), elapsed.count());
+}
+
+OcclusionTestResult SoftwareOcclusionCulling::Test(
+    const glm::mat4& worldViewProjection,
+    const glm::vec3& boundsMin,
+    const glm::vec3& boundsMax) const
+{
+    glm::vec3 ndcMin;
+    glm::vec3 ndcMax;
+    if (!ProjectBounds(worldViewProjection, boundsMin, boundsMax, ndcMin, ndcMax))
+    {
+        return OcclusionTestResult::Visible;
+    }
+
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f ||
+        ndcMax.y < -1.0f || ndcMin.y > 1.0f ||
+        ndcMin.z > 1.0f)
+    {
+        return OcclusionTestResult::OutsideFrustum;
+    }
+
+    const auto toPixel = [](float ndc, uint32_t size)
+    {
+        const auto pixel = static_cast<int32_t>(std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(size)));
+        return std::clamp(pixel, 0, static_cast<int32_t>(size) - 1);
+    };
+    const auto minX = toPixel(ndcMin.x, _width);
+    const auto maxX = toPixel(ndcMax.x, _width);
+    const auto minY = toPixel(ndcMin.y, _height);
+    const auto maxY = toPixel(ndcMax.y, _height);
+    const auto nearestDepth = ndcMin.z * 0.5f + 0.5f - DepthTestBias;
+
+    for (auto y = minY; y <= maxY; ++y)
+    {
+        const auto* row = _depth.data() + static_cast<size_t>(y) * _width;
+        for (auto x = minX; x <= maxX; ++x)
+        {
+            if (row[x] >= nearestDepth)
+            {
+                return OcclusionTestResult::Visible;
+            }
+        }
+    }
+
+    return OcclusionTestResult::Occluded;
+}
+
+float SoftwareOcclusionCulling::GetScreenCoverage(
+    const glm::mat4& worldViewProjection,
+    const glm::vec3& boundsMin,
+    const glm::vec3& boundsMax)
+{
+    glm::vec3 ndcMin;
+    glm::vec3 ndcMax;
+    if (!ProjectBounds(worldViewProjection, boundsMin, boundsMax, ndcMin, ndcMax))
+    {
+        return 1.0f;
+    }
+
+    const auto width = std::max(std::min(ndcMax.x, 1.0f) - std::max(ndcMin.x, -1.0f), 0.0f);
+    const auto height = std::max(std::min(ndcMax.y, 1.0f) - std::max(ndcMin.y, -1.0f), 0.0f);
+    return width * height / 4.0f;
+}
+
+uint32_t SoftwareOcclusionCulling::GetWidth() const
+{
+    return _width;
+}
+
+uint32_t SoftwareOcclusionCulling::GetHeight() const
+{
+    return _height;
+}
+
+const std::vector<float>& SoftwareOcclusionCulling::GetDepth() const
+{
+    return _depth;
+}
+
+bool SoftwareOcclusionCulling::IsAvx2Enabled()
+{
+    return IsAvx2Available;
+}
+
+const SoftwareOcclusionStatistics& SoftwareOcclusionCulling::GetStatistics() const
+{
+    return _statistics;
+}
+
+void SoftwareOcclusionCulling::SetupTriangles(const OccluderMesh& occluder, std::vector<Triangle>& triangles) const
+{
+    const auto width = static_cast<float>(_width);
+    const auto height = static_cast<float>(_height);
+    for (uint32_t index = 0; index + 2 < occluder.IndexCount; index += 3)
+    {
+        Triangle triangle;
+        float depth[3];
+        bool isRejected = false;
+        for (uint32_t vertex = 0; vertex < 3 && !isRejected; ++vertex)
+        {
+            const auto& position = occluder.Positions[occluder.Indices[index + vertex] + occluder.BaseVertex];
+            const auto clip = occluder.WorldViewProjection * glm::vec4(position, 1.0f);
+            if (clip.w <= std::numeric_limits<float>::epsilon() || clip.z < -clip.w)
+            {
+                isRejected = true;
+                break;
+            }
+
+            const auto screenX = (clip.x / clip.w * 0.5f + 0.5f) * width;
+            const auto screenY = (clip.y / clip.w * 0.5f + 0.5f) * height;
+            isRejected = screenX < -GuardBand || screenX > width + GuardBand ||
+                         screenY < -GuardBand || screenY > height + GuardBand;
+            triangle.X[vertex] = static_cast<int32_t>(std::lround(screenX * SubpixelScale));
+            triangle.Y[vertex] = static_cast<int32_t>(std::lround(screenY * SubpixelScale));
+            depth[vertex] = clip.z / clip.w * 0.5f + 0.5f;
+        }
+        if (isRejected)
+        {
+            continue;
+        }
+
+        // counter clockwise is front facing, drop back faces and degenerates
+        const auto doubleArea =
+            static_cast<int64_t>(triangle.X[1] - triangle.X[0]) * (triangle.Y[2] - triangle.Y[0]) -
+            static_cast<int64_t>(triangle.X[2] - triangle.X[0]) * (triangle.Y[1] - triangle.Y[0]);
+        if (doubleArea <= 0)
+        {
+            continue;
+        }
+
+        // pixels whose centers lie within the bounds of the vertices
+        const auto minX = std::min({ triangle.X[0], triangle.X[1], triangle.X[2] });
+        const auto maxX = std::max({ triangle.X[0], triangle.X[1], triangle.X[2] });
+        const auto minY = std::min({ triangle.Y[0], triangle.Y[1], triangle.Y[2] });
+        const auto maxY = std::max({ triangle.Y[0], triangle.Y[1], triangle.Y[2] });
+        triangle.MinX = std::max((minX - HalfPixel + SubpixelScale - 1) >> SubpixelBits, 0);
+        triangle.MinY = std::max((minY - HalfPixel + SubpixelScale - 1) >> SubpixelBits, 0);
+        triangle.MaxX = std::min((maxX - HalfPixel) >> SubpixelBits, static_cast<int32_t>(_width) - 1);
+        triangle.MaxY = std::min((maxY - HalfPixel) >> SubpixelBits, static_cast<int32_t>(_height) - 1);
+        if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+        {
+            continue;
+        }
+
+        // depth plane through the snapped vertices, in pixel units
+        const auto x0 = static_cast<float>(triangle.X[0]) / SubpixelScale;
+        const auto y0 = static_cast<float>(triangle.Y[0]) / SubpixelScale;
+        const auto deltaX1 = static_cast<float>(triangle.X[1] - triangle.X[0]) / SubpixelScale;
+        const auto deltaY1 = static_cast<float>(triangle.Y[1] - triangle.Y[0]) / SubpixelScale;
+        const auto deltaX2 = static_cast<float>(triangle.X[2] - triangle.X[0]) / SubpixelScale;
+        const auto deltaY2 = static_cast<float>(triangle.Y[2] - triangle.Y[0]) / SubpixelScale;
+        const auto deltaZ1 = depth[1] - depth[0];
+        const auto deltaZ2 = depth[2] - depth[0];
+        const auto area = deltaX1 * deltaY2 - deltaX2 * deltaY1;
+        triangle.DepthA = (deltaZ1 * deltaY2 - deltaZ2 * deltaY1) / area;
+        triangle.DepthB = (deltaZ2 * deltaX1 - deltaZ1 * deltaX2) / area;
+        triangle.DepthC = depth[0] - triangle.DepthA * x0 - triangle.DepthB * y0;
+
+        triangles.push_back(triangle);
+    }
+}
+
+void SoftwareOcclusionCulling::RasterizeTriangle(const Triangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY)
+{
+#if defined(HAS_AVX2_PATH)
+    if (IsAvx2Available)
+    {
+        RasterizeTriangleAvx2(triangle, minX, minY, maxX, maxY);
+        return;
+    }
+#endif
+    RasterizeTriangleScalar(triangle, minX, minY, maxX, maxY);
+}
+
+#if defined(HAS_AVX2_PATH)
+AVX2_FUNCTION void SoftwareOcclusionCulling::RasterizeTriangleAvx2(const Triangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY)
+{
+    // Edge function of edge i at a pixel center is RowConstant[i] - DeltaY[i] * centerX,
+    // non top-left edges are biased by one so that a plain >= 0 implements the fill rule
+    int32_t rowConstant[3];
+    int32_t deltaY[3];
+    int32_t deltaX[3];
+    int32_t bias[3];
+    for (int32_t edge = 0; edge < 3; ++edge)
+    {
+        const auto next = (edge + 1) % 3;
+        deltaX[edge] = triangle.X[next] - triangle.X[edge];
+        deltaY[edge] = triangle.Y[next] - triangle.Y[edge];
+        const auto isTopLeft = deltaY[edge] < 0 || (deltaY[edge] == 0 && deltaX[edge] < 0);
+        bias[edge] = isTopLeft ? 0 : 1;
+    }
+
+    const auto laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const auto depthA = _mm256_set1_ps(triangle.DepthA);
+    const auto depthB = _mm256_set1_ps(triangle.DepthB);
+    const auto depthC = _mm256_set1_ps(triangle.DepthC);
+    const auto half = _mm256_set1_ps(0.5f);
+    const auto minusOne = _mm256_set1_epi32(-1);
+    const auto startX = minX & ~7;
+
+    for (auto y = minY; y <= maxY; ++y)
+    {
+        const auto centerY = y * SubpixelScale + HalfPixel;
+        for (int32_t edge = 0; edge < 3; ++edge)
+        {
+            rowConstant[edge] = deltaX[edge] * (centerY - triangle.Y[edge]) + deltaY[edge] * triangle.X[edge] - bias[edge];
+        }
+        const auto rowConstant0 = _mm256_set1_epi32(rowConstant[0]);
+        const auto rowConstant1 = _mm256_set1_epi32(rowConstant[1]);
+        const auto rowConstant2 = _mm256_set1_epi32(rowConstant[2]);
+        const auto deltaY0 = _mm256_set1_epi32(deltaY[0]);
+        const auto deltaY1 = _mm256_set1_epi32(deltaY[1]);
+        const auto deltaY2 = _mm256_set1_epi32(deltaY[2]);
+        const auto pixelY = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(y)), half);
+
+        auto* row = _depth.data() + static_cast<size_t>(y) * _width;
+        for (auto x = startX; x <= maxX; x += 8)
+        {
+            // lanes left of minX or right of maxX are outside of the triangle and fail an edge test
+            const auto pixelX = _mm256_add_epi32(_mm256_set1_epi32(x), laneOffsets);
+            const auto centerX = _mm256_add_epi32(_mm256_slli_epi32(pixelX, SubpixelBits), _mm256_set1_epi32(HalfPixel));
+            const auto edge0 = _mm256_sub_epi32(rowConstant0, _mm256_mullo_epi32(deltaY0, centerX));
+            const auto edge1 = _mm256_sub_epi32(rowConstant1, _mm256_mullo_epi32(deltaY1, centerX));
+            const auto edge2 = _mm256_sub_epi32(rowConstant2, _mm256_mullo_epi32(deltaY2, centerX));
+            const auto inside = _mm256_cmpgt_epi32(_mm256_or_si256(_mm256_or_si256(edge0, edge1), edge2), minusOne);
+            if (_mm256_testz_si256(inside, inside))
+            {
+                continue;
+            }
+
+            const auto pixelXf = _mm256_add_ps(_mm256_cvtepi32_ps(pixelX), half);
+            const auto depth = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(depthA, pixelXf), _mm256_mul_ps(depthB, pixelY)),
+                depthC);
+            const auto previous = _mm256_loadu_ps(row + x);
+            const auto nearest = _mm256_min_ps(previous, depth);
+            _mm256_storeu_ps(row + x, _mm256_blendv_ps(previous, nearest, _mm256_castsi256_ps(inside)));
+        }
+    }
+}
+#endif
+
+void SoftwareOcclusionCulling::RasterizeTriangleScalar(const Triangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY)
+{
+    for (auto y = minY; y <= maxY; ++y)
+    {
+        const auto centerY = y * SubpixelScale + HalfPixel;
+        const auto pixelY = static_cast<float>(y) + 0.5f;
+        auto* row = _depth.data() + static_cast<size_t>(y) * _width;
+        for (auto x = minX; x <= maxX; ++x)
+        {
+            const auto centerX = x * SubpixelScale + HalfPixel;
+            bool isInside = true;
+            for (int32_t edge = 0; edge < 3; ++edge)
+            {
+                const auto next = (edge + 1) % 3;
+                const auto deltaX = triangle.X[next] - triangle.X[edge];
+                const auto deltaY = triangle.Y[next] - triangle.Y[edge];
+                const auto isTopLeft = deltaY < 0 || (deltaY == 0 && deltaX < 0);
+                const auto edgeValue = deltaX * (centerY - triangle.Y[edge]) - deltaY * (centerX - triangle.X[edge]);
+                isInside &= isTopLeft ? edgeValue >= 0 : edgeValue > 0;
+            }
+            if (!isInside)
+            {
+                continue;
+            }
+
+            const auto pixelX = static_cast<float>(x) + 0.5f;
+            const auto depth = triangle.DepthA * pixelX + triangle.DepthB * pixelY + triangle.DepthC;
+            row[x] = row[x] < depth ? row[x] : depth;
+        }
+    }
+}
+
+void SoftwareOcclusionCulling::UpdateStatistics(std::span<const OccluderMesh> occluders, uint32_t rasterizedTriangles, float milliseconds)
+{
+    _statistics.Occluders = static_cast<uint32_t>(occluders.size());
+    _statistics.SubmittedTriangles = 0;
+    for (const auto& occluder : occluders)
+    {
+        _statistics.SubmittedTriangles += occluder.IndexCount / 3;
+    }
+    _statistics.RasterizedTriangles = rasterizedTriangles;
+    _statistics.RasterizationMilliseconds = milliseconds;
+    _statistics.TrianglesPerMillisecond = milliseconds > 0.0f
+        ? static_cast<float>(_statistics.SubmittedTriangles) / milliseconds
+        : 0.0f;
+}
@@ -0,0 +1,221 @@
+#include <Project.Library/TextureStreamer.hpp>
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t TextureStreamer::CreateTexture(std::string_view filePath)
+{
+    StreamedTexture texture;
+    if (!LoadKtx2(filePath, texture.Image))
+    {
+        return 0;
+    }
+
+    const auto& formatInfo = texture.Image.FormatInfo;
+    int32_t isSupported = GL_FALSE;
+    glGetInternalformativ(GL_TEXTURE_2D, formatInfo.GLFormat, GL_INTERNALFORMAT_SUPPORTED, 1, &isSupported);
+    if (isSupported != GL_TRUE)
+    {
+        spdlog::error("TextureStreamer: {} uses format {:#x} which this GL implementation does not support", filePath, formatInfo.GLFormat);
+        return 0;
+    }
+
+    texture.IsStreamed = true;
+    texture.LevelCount = static_cast<uint32_t>(texture.Image.Levels.size());
+    texture.ResidentLevel = texture.LevelCount;
+    texture.RequestedLevel = texture.LevelCount - 1;
+    for (const auto& level : texture.Image.Levels)
+    {
+        texture.AllocatedBytes += level.Size;
+    }
+    texture.UncompressedBytes = GetUncompressedSize(texture.Image.Width, texture.Image.Height, texture.LevelCount);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture.Handle);
+    glTextureStorage2D(texture.Handle, texture.LevelCount, formatInfo.GLFormat, texture.Image.Width, texture.Image.Height);
+    glTextureParameteri(texture.Handle, GL_TEXTURE_MAX_LEVEL, texture.LevelCount - 1);
+
+    // the tail always, so there is something to sample from the first frame on
+    for (auto level = texture.LevelCount; level-- > 0;)
+    {
+        const auto& imageLevel = texture.Image.Levels[level];
+        if (level != texture.LevelCount - 1 && std::max(imageLevel.Width, imageLevel.Height) > TailSize)
+        {
+            break;
+        }
+        UploadLevel(texture, level);
+    }
+
+    _textureIndices[texture.Handle] = _textures.size();
+    _textures.push_back(std::move(texture));
+    UpdateStatistics(0);
+    return _textures.back().Handle;
+}
+
+void TextureStreamer::TrackTexture(uint32_t texture, uint32_t width, uint32_t height, uint32_t levels)
+{
+    StreamedTexture tracked;
+    tracked.Handle = texture;
+    tracked.LevelCount = levels;
+    tracked.AllocatedBytes = GetUncompressedSize(width, height, levels);
+    tracked.ResidentBytes = tracked.AllocatedBytes;
+    tracked.UncompressedBytes = GetUncompressedSize(width, height, static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1);
+
+    _textureIndices[texture] = _textures.size();
+    _textures.push_back(std::move(tracked));
+    UpdateStatistics(0);
+}
+
+void TextureStreamer::Release()
+{
+    for (auto& texture : _textures)
+    {
+        if (texture.IsStreamed)
+        {
+            glDeleteTextures(1, &texture.Handle);
+        }
+    }
+    _textures.clear();
+    _textureIndices.clear();
+    _statistics = {};
+}
+
+void TextureStreamer::RequestScreenSize(uint32_t texture, float pixels)
+{
+    const auto index = _textureIndices.find(texture);
+    if (index == _textureIndices.end() || !_textures[index->second].IsStreamed || pixels <= 0.0f)
+    {
+        return;
+    }
+
+    auto& streamed = _textures[index->second];
+    const auto level = GetLevelForScreenSize(streamed.Image.Width, streamed.Image.Height, streamed.LevelCount, pixels);
+    streamed.RequestedLevel = std::min(streamed.RequestedLevel, level);
+}
+
+void TextureStreamer::Update(size_t uploadBudget)
+{
+    ZoneScopedN("Texture Streaming");
+
+    // the textures furthest from what was asked for go first
+    std::vector<StreamedTexture*> waiting;
+    for (auto& texture : _textures)
+    {
+        if (texture.IsStreamed && texture.ResidentLevel > texture.RequestedLevel)
+        {
+            waiting.push_back(&texture);
+        }
+    }
+    std::stable_sort(waiting.begin(), waiting.end(), [](const StreamedTexture* lhs, const StreamedTexture* rhs)
+    {
+        return lhs->ResidentLevel - lhs->RequestedLevel > rhs->ResidentLevel - rhs->RequestedLevel;
+    });
+
+    // one level per texture per round, so a single huge texture does not starve the others
+    size_t uploadedBytes = 0;
+    auto hasUploaded = true;
+    while (hasUploaded)
+    {
+        hasUploaded = false;
+        for (auto* texture : waiting)
+        {
+            if (texture->ResidentLevel <= texture->RequestedLevel)
+            {
+                continue;
+            }
+            const auto level = texture->ResidentLevel - 1;
+            const auto size = texture->Image.Levels[level].Size;
+            if (uploadedBytes > 0 && uploadedBytes + size > uploadBudget)
+            {
+                continue;
+            }
+            UploadLevel(*texture, level);
+            uploadedBytes += size;
+            hasUploaded = true;
+        }
+    }
+
+    UpdateStatistics(uploadedBytes);
+    for (auto& texture : _textures)
+    {
+        texture.RequestedLevel = texture.LevelCount > 0 ? texture.LevelCount - 1 : 0;
+    }
+}
+
+const TextureMemoryStatistics& TextureStreamer::GetStatistics() const
+{
+    return _statistics;
+}
+
+void TextureStreamer::UploadLevel(StreamedTexture& texture, uint32_t level)
+{
+    const auto& formatInfo = texture.Image.FormatInfo;
+    const auto& imageLevel = texture.Image.Levels[level];
+    const auto* data = texture.Image.Data.data() + imageLevel.Offset;
+    if (formatInfo.IsCompressed)
+    {
+        glCompressedTextureSubImage2D(
+            texture.Handle,
+            level,
+            0, 0,
+            imageLevel.Width, imageLevel.Height,
+            formatInfo.GLFormat,
+            static_cast<int32_t>(imageLevel.Size),
+            data);
+    }
+    else
+    {
+        glTextureSubImage2D(texture.Handle, level, 0, 0, imageLevel.Width, imageLevel.Height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+
+    texture.ResidentLevel = level;
+    texture.ResidentBytes += imageLevel.Size;
+    glTextureParameteri(texture.Handle, GL_TEXTURE_BASE_LEVEL, level);
+
+    if (level == 0)
+    {
+        texture.Image.Data.clear();
+        texture.Image.Data.shrink_to_fit();
+    }
+}
+
+void TextureStreamer::UpdateStatistics(size_t uploadedBytes)
+{
+    _statistics = {};
+    _statistics.Textures = static_cast<uint32_t>(_textures.size());
+    _statistics.UploadedBytes = uploadedBytes;
+    for (const auto& texture : _textures)
+    {
+        _statistics.CompressedTextures += texture.Image.FormatInfo.IsCompressed;
+        _statistics.UncompressedBytes += texture.UncompressedBytes;
+        _statistics.AllocatedBytes += texture.AllocatedBytes;
+        _statistics.ResidentBytes += texture.ResidentBytes;
+        if (texture.IsStreamed && texture.ResidentLevel > texture.RequestedLevel)
+        {
+            _statistics.StreamingTextures++;
+            for (auto level = texture.RequestedLevel; level < texture.ResidentLevel; ++level)
+            {
+                _statistics.PendingBytes += texture.Image.Levels[level].Size;
+            }
+        }
+    }
+}
+
+uint32_t TextureStreamer::GetLevelForScreenSize(uint32_t width, uint32_t height, uint32_t levelCount, float pixels)
+{
+    const auto size = static_cast<float>(std::max(width, height));
+    return static_cast<uint32_t>(std::clamp(std::floor(std::log2(size / pixels)), 0.0f, static_cast<float>(levelCount - 1)));
+}
+
+size_t TextureStreamer::GetUncompressedSize(uint32_t width, uint32_t height, uint32_t levels)
+{
+    size_t size = 0;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        size += static_cast<size_t>(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * 4;
+    }
+    return size;
+}
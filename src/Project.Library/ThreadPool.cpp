@@ -0,0 +1,106 @@
+#include <Project.Library/ThreadPool.hpp>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    _workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        // thread index 0 is the one calling ParallelFor
+        _workers.emplace_back(&ThreadPool::WorkerMain, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _isStopping = true;
+    }
+    _wakeCondition.notify_all();
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(_workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t chunkSize, const ChunkFunction& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    chunkSize = std::max(chunkSize, 1u);
+    const auto chunkCount = (count + chunkSize - 1) / chunkSize;
+    if (_workers.empty() || chunkCount == 1)
+    {
+        function(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        _function = &function;
+        _count = count;
+        _chunkSize = chunkSize;
+        _chunkCount = chunkCount;
+        _nextChunk.store(0, std::memory_order_relaxed);
+        _busyWorkers = static_cast<uint32_t>(_workers.size());
+        _generation++;
+    }
+    _wakeCondition.notify_all();
+
+    RunChunks(0);
+
+    std::unique_lock lock(_mutex);
+    _doneCondition.wait(lock, [this] { return _busyWorkers == 0; });
+    _function = nullptr;
+}
+
+void ThreadPool::WorkerMain(uint32_t threadIndex)
+{
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(_mutex);
+            _wakeCondition.wait(lock, [&] { return _isStopping || _generation != seenGeneration; });
+            if (_isStopping)
+            {
+                return;
+            }
+            seenGeneration = _generation;
+        }
+
+        RunChunks(threadIndex);
+
+        {
+            std::lock_guard lock(_mutex);
+            _busyWorkers--;
+        }
+        _doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::RunChunks(uint32_t threadIndex)
+{
+    uint32_t chunk;
+    while ((chunk = _nextChunk.fetch_add(1, std::memory_order_relaxed)) < _chunkCount)
+    {
+        const auto begin = chunk * _chunkSize;
+        const auto end = std::min(begin + _chunkSize, _count);
+        (*_function)(begin, end, threadIndex);
+    }
+}
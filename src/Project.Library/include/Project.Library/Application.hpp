@@ -1,4 +1,8 @@
 #pragma once
+#include <Project.Library/FramePacer.hpp>
+#include <Project.Library/GLStateCache.hpp>
+#include <Project.Library/RenderGraph.hpp>
+
 #include <cstdint>
 
 struct GLFWwindow;
@@ -11,14 +15,22 @@ public:
 protected:
     void Close();
     bool IsKeyPressed(int32_t key);
+    void GetFramebufferSize(int32_t& width, int32_t& height);
     
     double GetDeltaTime();
+    const RenderGraph& GetRenderGraph() const;
+    // Invalidated before the render graph executes, so only valid inside passes
+    GLStateCache& GetStateCache();
+    FramePacer& GetFramePacer();
 
     virtual void AfterCreatedUiContext();
     virtual void BeforeDestroyUiContext();
     virtual bool Initialize();
     virtual bool Load();
     virtual void Unload();
+    // Declare the frame's passes and return the backbuffer version the UI gets drawn on top of,
+    // the default draws RenderScene straight into the backbuffer
+    virtual RenderGraphResource BuildRenderGraph(RenderGraph& renderGraph, RenderGraphResource backbuffer, float deltaTime);
     virtual void RenderScene(float deltaTime);
     virtual void RenderUI(float deltaTime);
     virtual void Update(float deltaTime);
@@ -26,6 +38,9 @@ protected:
 
 private:
     GLFWwindow* _windowHandle = nullptr;
+    RenderGraph _renderGraph;
+    GLStateCache _stateCache;
+    FramePacer _framePacer;
     void Render(float deltaTime);
 
 };
\ No newline at end of file
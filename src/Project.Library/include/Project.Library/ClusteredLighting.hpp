@@ -0,0 +1,124 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// World space, laid out for std430 so it can be uploaded as is
+struct LightData
+{
+    glm::vec3 Position = {};
+    float Range = 1.0f;
+    glm::vec3 Color = glm::vec3(1.0f);
+    float Intensity = 1.0f;
+    // spot lights only
+    glm::vec3 Direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    // cosine of the outer cone angle, -1 or less makes a point light
+    float SpotOuterCos = -1.0f;
+    float SpotInnerCos = -1.0f;
+    float Padding[3] = {};
+};
+
+// Slice of GetLightIndices() belonging to one cluster
+struct ClusterLightRange
+{
+    uint32_t Offset;
+    uint32_t Count;
+
+    bool operator==(const ClusterLightRange&) const = default;
+};
+
+struct ClusteredLightingStatistics
+{
+    uint32_t Lights = 0;
+    uint32_t LightIndices = 0;
+    uint32_t OccupiedClusters = 0;
+    uint32_t MaxLightsPerCluster = 0;
+    float AssignmentMilliseconds = 0.0f;
+};
+
+// Light lists for a grid of froxels, screen space tiles split into slices that get
+// exponentially deeper between the near and the far plane.
+//
+// Every light is bounded by a view space sphere (the cone's bounding sphere for spot
+// lights) and assigned to every cluster whose view space box it touches. Assign only
+// runs that test on the clusters inside the light's slice and tile range, four tiles at
+// a time with SSE, and works on slices in parallel. AssignReference runs it on every
+// cluster and light. Both produce the exact same ranges and indices, every list sorted
+// by light index.
+//
+// Clusters are indexed (slice * TilesY + tileY) * TilesX + tileX, tile 0 is the bottom
+// left one like gl_FragCoord. A fragment finds its slice as
+// floor(log(viewDepth) * GetSliceScale() + GetSliceBias()).
+class ClusteredLighting
+{
+public:
+    explicit ClusteredLighting(uint32_t tilesX = 16, uint32_t tilesY = 9, uint32_t slices = 24);
+
+    // Symmetric perspective projections only, cluster bounds are rebuilt when anything changed
+    void SetProjection(const glm::mat4& projection, float nearPlane, float farPlane);
+
+    void Assign(std::span<const LightData> lights, const glm::mat4& view, ThreadPool& threadPool);
+    void AssignReference(std::span<const LightData> lights, const glm::mat4& view);
+
+    [[nodiscard]] uint32_t GetTilesX() const;
+    [[nodiscard]] uint32_t GetTilesY() const;
+    [[nodiscard]] uint32_t GetSlices() const;
+    [[nodiscard]] float GetSliceScale() const;
+    [[nodiscard]] float GetSliceBias() const;
+
+    [[nodiscard]] const std::vector<ClusterLightRange>& GetClusters() const;
+    [[nodiscard]] const std::vector<uint32_t>& GetLightIndices() const;
+    [[nodiscard]] const ClusteredLightingStatistics& GetStatistics() const;
+
+private:
+    struct Sphere
+    {
+        glm::vec3 Center;
+        float Radius;
+    };
+
+    struct ClusterBounds
+    {
+        glm::vec3 Min;
+        glm::vec3 Max;
+    };
+
+    static Sphere GetViewSpaceBounds(const LightData& light, const glm::mat4& view);
+    [[nodiscard]] float GetSliceDepth(uint32_t slice) const;
+    [[nodiscard]] int32_t GetSliceUnclamped(float viewDepth) const;
+    [[nodiscard]] uint32_t GetClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const;
+    void UpdateStatistics(uint32_t lightCount, float milliseconds);
+
+    uint32_t _tilesX;
+    uint32_t _tilesY;
+    uint32_t _slices;
+
+    glm::mat4 _projection = glm::mat4(0.0f);
+    float _nearPlane = 0.0f;
+    float _farPlane = 0.0f;
+    float _sliceScale = 0.0f;
+    float _sliceBias = 0.0f;
+    std::vector<ClusterBounds> _clusterBounds;
+    // x extents per slice and tileX, y extents per slice and tileY, for the vectorized tests
+    std::vector<float> _tileMinX;
+    std::vector<float> _tileMaxX;
+    std::vector<float> _tileMinY;
+    std::vector<float> _tileMaxY;
+
+    std::vector<ClusterLightRange> _clusters;
+    std::vector<uint32_t> _lightIndices;
+
+    // Assign scratch, reused across frames
+    std::vector<Sphere> _lightSpheres;
+    std::vector<int32_t> _lightSlices;
+    // (cluster, light) pairs per slice in light order
+    std::vector<std::vector<uint64_t>> _slicePairs;
+
+    ClusteredLightingStatistics _statistics;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// 64 bit draw sort key, most significant field first:
+// pass (4 bits) | program (12 bits) | material or texture set (24 bits) | depth bucket (24 bits)
+// Sorting ascending groups draws by the state that is the most expensive to change
+// and orders them front to back inside a state group. Fields wider than their bits are truncated.
+struct DrawSortKey
+{
+    static constexpr uint32_t PassBits = 4;
+    static constexpr uint32_t ProgramBits = 12;
+    static constexpr uint32_t MaterialBits = 24;
+    static constexpr uint32_t DepthBits = 24;
+
+    static constexpr uint32_t DepthShift = 0;
+    static constexpr uint32_t MaterialShift = DepthShift + DepthBits;
+    static constexpr uint32_t ProgramShift = MaterialShift + MaterialBits;
+    static constexpr uint32_t PassShift = ProgramShift + ProgramBits;
+
+    [[nodiscard]] static constexpr uint64_t Make(uint32_t pass, uint32_t program, uint32_t material, uint32_t depth)
+    {
+        return (static_cast<uint64_t>(pass & Mask(PassBits)) << PassShift) |
+            (static_cast<uint64_t>(program & Mask(ProgramBits)) << ProgramShift) |
+            (static_cast<uint64_t>(material & Mask(MaterialBits)) << MaterialShift) |
+            (static_cast<uint64_t>(depth & Mask(DepthBits)) << DepthShift);
+    }
+
+    [[nodiscard]] static constexpr uint32_t GetPass(uint64_t key) { return static_cast<uint32_t>(key >> PassShift) & Mask(PassBits); }
+    [[nodiscard]] static constexpr uint32_t GetProgram(uint64_t key) { return static_cast<uint32_t>(key >> ProgramShift) & Mask(ProgramBits); }
+    [[nodiscard]] static constexpr uint32_t GetMaterial(uint64_t key) { return static_cast<uint32_t>(key >> MaterialShift) & Mask(MaterialBits); }
+    [[nodiscard]] static constexpr uint32_t GetDepth(uint64_t key) { return static_cast<uint32_t>(key >> DepthShift) & Mask(DepthBits); }
+
+    // normalizedDepth is clamped to [0, 1], back to front orders (transparent) draws farthest first
+    [[nodiscard]] static uint32_t QuantizeDepth(float normalizedDepth, bool backToFront = false);
+
+private:
+    static constexpr uint32_t Mask(uint32_t bits)
+    {
+        return bits >= 32 ? UINT32_MAX : (1u << bits) - 1;
+    }
+};
+
+// Stable LSD radix sort of 64 bit keys, 8 bits per pass, parallel over chunks of the input.
+// Every pass histograms the chunks in parallel, prefix sums digit major so equal digits
+// keep their chunk order and scatters the chunks in parallel. Passes in which all keys
+// share the digit are skipped, sort keys tend to have a lot of constant high bits.
+class RadixSorter
+{
+public:
+    // values is permuted along with keys and may be empty
+    void Sort(std::span<uint64_t> keys, std::span<uint32_t> values, ThreadPool& threadPool);
+
+    // Digit passes the last Sort actually scattered in, at most 8
+    [[nodiscard]] uint32_t GetScatterPassCount() const;
+
+private:
+    static constexpr uint32_t RadixBits = 8;
+    static constexpr uint32_t RadixSize = 1 << RadixBits;
+
+    std::vector<uint64_t> _keyScratch;
+    std::vector<uint32_t> _valueScratch;
+    std::vector<std::array<uint32_t, RadixSize>> _histograms;
+    uint32_t _scatterPassCount = 0;
+};
+
+// Draws of one frame as key plus an item the caller maps back to its own draw data
+class DrawQueue
+{
+public:
+    void Clear();
+    void Add(uint64_t key, uint32_t item);
+    void Sort(ThreadPool& threadPool);
+
+    [[nodiscard]] uint32_t GetSize() const;
+    [[nodiscard]] std::span<const uint64_t> GetKeys() const;
+    [[nodiscard]] std::span<const uint32_t> GetItems() const;
+    [[nodiscard]] float GetSortMilliseconds() const;
+
+private:
+    std::vector<uint64_t> _keys;
+    std::vector<uint32_t> _items;
+    RadixSorter _sorter;
+    float _sortMilliseconds = 0.0f;
+};
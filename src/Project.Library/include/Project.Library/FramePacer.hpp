@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+struct GLFWwindow;
+
+// Values are the swap interval handed to glfwSwapInterval
+enum class VsyncMode : int32_t
+{
+    Off = 0,
+    On = 1,
+    // tears instead of waiting a whole refresh when a frame is late, falls back to On without
+    // WGL_EXT_swap_control_tear or GLX_EXT_swap_control_tear
+    Adaptive = -1,
+    Half = 2
+};
+
+struct FramePacingSettings
+{
+    VsyncMode Vsync = VsyncMode::On;
+    // frames the CPU may queue ahead of the GPU, fences of older frames are waited on
+    uint32_t MaxFramesInFlight = 2;
+    // sleep before sampling input so the frame finishes just in time for its deadline
+    bool IsJustInTimeEnabled = false;
+    float JustInTimeMarginMilliseconds = 1.0f;
+    // GPU time the dynamic resolution scaler holds, without vsync just in time waits pace to it as well
+    float TargetFrameMilliseconds = 16.0f;
+    bool IsDynamicResolutionEnabled = false;
+    float MinRenderScale = 0.5f;
+    float MaxRenderScale = 1.0f;
+};
+
+// Fixed width bins from 0 to MaxMilliseconds, the last bin takes everything above
+class FrameHistogram
+{
+public:
+    FrameHistogram(float maxMilliseconds, uint32_t binCount);
+
+    void Add(float milliseconds);
+    void Reset();
+
+    [[nodiscard]] float GetPercentile(float percentile) const;
+    [[nodiscard]] float GetBinMilliseconds() const;
+    [[nodiscard]] uint32_t GetSampleCount() const;
+    // float so ImGui::PlotHistogram can take them as they are
+    [[nodiscard]] const std::vector<float>& GetBins() const;
+
+private:
+    float _maxMilliseconds;
+    std::vector<float> _bins;
+    uint32_t _sampleCount = 0;
+};
+
+// One frame, complete once the GPU is done with it
+struct FrameRecord
+{
+    uint64_t Frame = 0;
+    // input sample to input sample
+    float FrameMilliseconds = 0.0f;
+    // input sample to the swap call
+    float CpuMilliseconds = 0.0f;
+    // BeginGpuWork to the GPU finishing the frame
+    float GpuMilliseconds = 0.0f;
+    // input sample to the GPU finishing the frame, scanout not included
+    float LatencyMilliseconds = 0.0f;
+    float FenceWaitMilliseconds = 0.0f;
+    float JustInTimeWaitMilliseconds = 0.0f;
+    float RenderScale = 1.0f;
+};
+
+struct FramePacingStatistics
+{
+    FrameRecord LastFrame;
+    float PredictedCostMilliseconds = 0.0f;
+    float RefreshMilliseconds = 0.0f;
+    uint32_t FramesInFlight = 0;
+    bool IsAdaptiveVsyncSupported = false;
+};
+
+// Paces the main loop, BeginFrame goes before input is polled, BeginGpuWork right before the
+// frame's GL commands are recorded and Present replaces the swap.
+//
+// Every frame gets a fence and two timestamp queries, the current GL time is sampled right
+// where input is, so latency comes from the GPU clock alone. GPU time starts at BeginGpuWork,
+// polling and updating on the CPU would otherwise count towards it. Results are picked up once the
+// fence has signaled, without stalling unless the frames in flight cap asks for it.
+//
+// Just in time waits place the input sample at the next deadline (a refresh period after the
+// last swap, or the target frame time after the last deadline without vsync) minus the
+// predicted frame cost.
+// The prediction is a moving average of the larger of CPU and GPU time, so it works best
+// with a single frame in flight where the swap returns on the vertical blank.
+class FramePacer
+{
+public:
+    static constexpr uint32_t MaxQueuedFrames = 4;
+    static constexpr uint32_t HistorySize = 4096;
+
+    FramePacer();
+
+    // Needs a current GL context
+    void Initialize();
+    void Release();
+
+    void BeginFrame();
+    // Once per frame, between BeginFrame and Present
+    void BeginGpuWork();
+    void Present(GLFWwindow* window);
+
+    [[nodiscard]] FramePacingSettings& GetSettings();
+    // Off for render paths that always draw at the window size, the scale then stays at 1
+    void SetDynamicResolutionSupported(bool isSupported);
+    // Quantized to 5% steps, so transient render targets are not reallocated every frame
+    [[nodiscard]] float GetRenderScale() const;
+    void GetRenderSize(int32_t width, int32_t height, int32_t& renderWidth, int32_t& renderHeight) const;
+
+    [[nodiscard]] const FramePacingStatistics& GetStatistics() const;
+    [[nodiscard]] const FrameHistogram& GetFrameTimeHistogram() const;
+    [[nodiscard]] const FrameHistogram& GetLatencyHistogram() const;
+    void ResetHistograms();
+    // The frame history then both histograms
+    bool ExportCsv(std::string_view filePath) const;
+    void WriteCsv(std::ostream& file) const;
+    // Called for every frame the GPU finished, feeds the histograms, the history and the cost prediction
+    void AddCompletedFrame(const FrameRecord& record);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedFrame
+    {
+        void* Fence = nullptr;
+        uint32_t StartQuery = 0;
+        uint32_t EndQuery = 0;
+        int64_t InputGpuTime = 0;
+        FrameRecord Record;
+    };
+
+    void ApplyVsync();
+    // true if the oldest frame completed, blocking waits for it
+    bool RetireOldestFrame(bool isBlocking);
+    void UpdateRenderScale(float gpuMilliseconds);
+    [[nodiscard]] float GetFramePeriodMilliseconds() const;
+    static void WaitUntil(Clock::time_point time);
+
+    FramePacingSettings _settings;
+    VsyncMode _appliedVsync = VsyncMode::On;
+    bool _isInitialized = false;
+
+    std::array<QueuedFrame, MaxQueuedFrames> _queuedFrames;
+    uint32_t _oldestFrame = 0;
+    uint32_t _queuedFrameCount = 0;
+    uint64_t _frameIndex = 0;
+
+    Clock::time_point _inputTime;
+    // when the next frame should be done
+    Clock::time_point _deadline;
+    float _renderScale = 1.0f;
+    bool _isDynamicResolutionSupported = true;
+
+    FramePacingStatistics _statistics;
+    FrameHistogram _frameTimeHistogram;
+    FrameHistogram _latencyHistogram;
+    std::vector<FrameRecord> _history;
+    size_t _historyNext = 0;
+};
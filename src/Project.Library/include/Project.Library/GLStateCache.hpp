@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum class GLStateType : uint8_t
+{
+    Program,
+    VertexArray,
+    Texture,
+    BufferBase,
+    Buffer,
+    Count
+};
+
+struct GLStateCacheStatistics
+{
+    // calls that reached GL vs calls skipped because the state was already set, per GLStateType
+    std::array<uint32_t, static_cast<size_t>(GLStateType::Count)> Issued = {};
+    std::array<uint32_t, static_cast<size_t>(GLStateType::Count)> Skipped = {};
+};
+
+// Shadows the bind points draw submission touches and drops binds that would not change anything.
+//
+// The cache only knows about binds that went through it. Anything else changing these
+// bind points (ImGui, deleting a bound object and reusing its name) has to be followed
+// by Invalidate(), Application does that once per frame before executing the render graph.
+class GLStateCache
+{
+public:
+    static constexpr uint32_t MaxTextureUnits = 32;
+    static constexpr uint32_t MaxBufferBindings = 16;
+
+    GLStateCache();
+
+    // Forgets all bind points and resets the statistics
+    void BeginFrame();
+    void Invalidate();
+
+    void UseProgram(uint32_t program);
+    void BindVertexArray(uint32_t vertexArray);
+    void BindTextureUnit(uint32_t unit, uint32_t texture);
+    // GL_SHADER_STORAGE_BUFFER and GL_UNIFORM_BUFFER
+    void BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer);
+    // GL_DRAW_INDIRECT_BUFFER and GL_DISPATCH_INDIRECT_BUFFER
+    void BindBuffer(uint32_t target, uint32_t buffer);
+
+    [[nodiscard]] const GLStateCacheStatistics& GetStatistics() const;
+
+private:
+    // 0 is a valid binding to go back to, so unknown gets its own value
+    static constexpr uint32_t Unknown = UINT32_MAX;
+
+    bool Update(GLStateType type, uint32_t& current, uint32_t value);
+
+    uint32_t _program = Unknown;
+    uint32_t _vertexArray = Unknown;
+    std::array<uint32_t, MaxTextureUnits> _textures;
+    std::array<uint32_t, MaxBufferBindings> _storageBuffers;
+    std::array<uint32_t, MaxBufferBindings> _uniformBuffers;
+    uint32_t _drawIndirectBuffer = Unknown;
+    uint32_t _dispatchIndirectBuffer = Unknown;
+
+    GLStateCacheStatistics _statistics;
+};
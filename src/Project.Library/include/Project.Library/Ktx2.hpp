@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// The VkFormat values KTX2 files name their format with
+enum class Ktx2Format : uint32_t
+{
+    Undefined = 0,
+    R8G8B8A8Unorm = 37,
+    R8G8B8A8Srgb = 43,
+    Bc1RgbUnorm = 131,
+    Bc1RgbSrgb = 132,
+    Bc1RgbaUnorm = 133,
+    Bc1RgbaSrgb = 134,
+    Bc2Unorm = 135,
+    Bc2Srgb = 136,
+    Bc3Unorm = 137,
+    Bc3Srgb = 138,
+    Bc4Unorm = 139,
+    Bc4Snorm = 140,
+    Bc5Unorm = 141,
+    Bc5Snorm = 142,
+    Bc6hUfloat = 143,
+    Bc6hSfloat = 144,
+    Bc7Unorm = 145,
+    Bc7Srgb = 146,
+    Astc4x4Unorm = 157,
+    Astc4x4Srgb = 158
+};
+
+struct Ktx2FormatInfo
+{
+    Ktx2Format Format = Ktx2Format::Undefined;
+    // GL internal format, e.g. GL_COMPRESSED_RGBA_BPTC_UNORM
+    uint32_t GLFormat = 0;
+    uint32_t BlockWidth = 1;
+    uint32_t BlockHeight = 1;
+    uint32_t BlockBytes = 0;
+    bool IsCompressed = false;
+};
+
+struct Ktx2Level
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    // into Ktx2Image::Data
+    size_t Offset = 0;
+    size_t Size = 0;
+};
+
+// A single 2D image with its mip chain, level 0 is the largest.
+// Array, cube, 3D and supercompressed (Basis, Zstandard) files are rejected.
+struct Ktx2Image
+{
+    Ktx2FormatInfo FormatInfo;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    std::vector<Ktx2Level> Levels;
+    std::vector<uint8_t> Data;
+};
+
+// nullptr for formats without a GL mapping
+[[nodiscard]] const Ktx2FormatInfo* GetKtx2FormatInfo(Ktx2Format format);
+[[nodiscard]] size_t GetKtx2LevelSize(const Ktx2FormatInfo& formatInfo, uint32_t width, uint32_t height);
+
+bool ReadKtx2(std::span<const uint8_t> file, Ktx2Image& image);
+bool LoadKtx2(std::string_view filePath, Ktx2Image& image);
+// Levels are laid out smallest first with a basic data format descriptor, as the spec asks for
+bool WriteKtx2(const Ktx2Image& image, std::vector<uint8_t>& file);
+bool SaveKtx2(std::string_view filePath, const Ktx2Image& image);
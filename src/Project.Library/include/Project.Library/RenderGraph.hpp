@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Handle to one version of a virtual resource, only valid for the frame it was declared in.
+// Every write produces a new version, readers depend on the pass that produced the version they read
+using RenderGraphResource = uint32_t;
+constexpr RenderGraphResource InvalidRenderGraphResource = UINT32_MAX;
+
+enum class RenderGraphResourceType : uint8_t
+{
+    Texture,
+    Buffer
+};
+
+// How a pass touches a resource. Writes through ImageLoadStore and StorageBuffer
+// are incoherent in GL, everything that consumes them afterwards needs the
+// matching glMemoryBarrier bit, which the graph works out from the reader's access
+enum class RenderGraphAccess : uint32_t
+{
+    None = 0,
+    TextureFetch = 1 << 0,
+    ImageLoadStore = 1 << 1,
+    StorageBuffer = 1 << 2,
+    UniformBuffer = 1 << 3,
+    IndirectCommand = 1 << 4,
+    VertexAttribute = 1 << 5,
+    ElementArray = 1 << 6,
+    Framebuffer = 1 << 7,
+    BufferUpdate = 1 << 8,
+    TextureUpdate = 1 << 9,
+    PixelBuffer = 1 << 10
+};
+
+constexpr RenderGraphAccess operator|(RenderGraphAccess lhs, RenderGraphAccess rhs)
+{
+    return static_cast<RenderGraphAccess>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
+constexpr RenderGraphAccess operator&(RenderGraphAccess lhs, RenderGraphAccess rhs)
+{
+    return static_cast<RenderGraphAccess>(static_cast<uint32_t>(lhs) & static_cast<uint32_t>(rhs));
+}
+
+struct RenderGraphTextureDesc
+{
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    // GL internal format, e.g. GL_RGBA8
+    uint32_t Format = 0;
+    uint32_t Levels = 1;
+
+    bool operator==(const RenderGraphTextureDesc&) const = default;
+};
+
+struct RenderGraphBufferDesc
+{
+    size_t Size = 0;
+};
+
+struct RenderGraphStats
+{
+    uint32_t DeclaredPasses = 0;
+    uint32_t CulledPasses = 0;
+    uint32_t TransientResources = 0;
+    uint32_t PhysicalResources = 0;
+    // what the transients would cost with one allocation each
+    size_t TransientMemoryWithoutAliasing = 0;
+    // what the physical allocations after aliasing cost
+    size_t TransientMemoryWithAliasing = 0;
+    // lower bound, the largest sum of resources alive at the same pass
+    size_t PeakLiveTransientMemory = 0;
+    // one barrier per read-after-incoherent-write edge vs what actually gets issued
+    uint32_t UnbatchedBarriers = 0;
+    uint32_t BatchedBarriers = 0;
+};
+
+class RenderGraphBuilder;
+class RenderGraphContext;
+
+// Frame graph, rebuilt every frame.
+//
+// Passes declare which resource versions they read and write, Compile() orders
+// them by those dependencies (a write also waits for the readers of the version
+// it replaces, ties are broken by declaration order), culls passes whose results
+// nobody consumes, computes resource lifetimes, aliases transient resources with
+// disjoint lifetimes onto shared physical allocations and folds the required
+// glMemoryBarrier calls into one per pass. Barriers follow the physical allocation,
+// so a resource aliased onto memory with a pending incoherent write waits for it.
+// Compile() does not touch GL, it lives in RenderGraphCompile.cpp without GL includes. Execute() does.
+//
+// GL has no placement of textures into raw memory, so textures only alias when
+// their descriptions match. Buffers alias when their lifetimes are disjoint, the
+// physical buffer is sized for the largest one.
+class RenderGraph
+{
+public:
+    using SetupFunction = std::function<void(RenderGraphBuilder&)>;
+    using ExecuteFunction = std::function<void(RenderGraphContext&)>;
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    void Reset();
+    void Release();
+
+    RenderGraphResource CreateTexture(std::string_view name, const RenderGraphTextureDesc& desc);
+    RenderGraphResource CreateBuffer(std::string_view name, const RenderGraphBufferDesc& desc);
+    // Imported resources live outside of the graph, writing to them keeps a pass alive
+    RenderGraphResource ImportTexture(std::string_view name, uint32_t texture, const RenderGraphTextureDesc& desc = {});
+    RenderGraphResource ImportBuffer(std::string_view name, uint32_t buffer, const RenderGraphBufferDesc& desc = {});
+
+    void AddPass(std::string_view name, const SetupFunction& setup, ExecuteFunction execute);
+
+    bool Compile();
+    void Execute();
+
+    [[nodiscard]] const RenderGraphStats& GetStats() const;
+    // Execution order of the compiled frame, culled passes are not part of it
+    [[nodiscard]] std::vector<std::string_view> GetPassOrder() const;
+    // Physical slot a transient resource was aliased onto, InvalidRenderGraphResource for imported or unused ones
+    [[nodiscard]] uint32_t GetPhysicalSlot(RenderGraphResource resource) const;
+    // Accumulated RenderGraphAccess bits of the barrier issued before the given pass
+    [[nodiscard]] RenderGraphAccess GetBarrierBeforePass(std::string_view name) const;
+
+    static size_t GetTextureSize(const RenderGraphTextureDesc& desc);
+
+private:
+    friend class RenderGraphBuilder;
+    friend class RenderGraphContext;
+
+    // For writes Version is the version the write produced
+    struct ResourceAccess
+    {
+        RenderGraphResource Version;
+        RenderGraphAccess Access;
+    };
+
+    struct ResourceVersion
+    {
+        uint32_t Resource;
+        uint32_t Producer = UINT32_MAX;
+        RenderGraphResource Previous = InvalidRenderGraphResource;
+    };
+
+    struct Pass
+    {
+        std::string Name;
+        std::vector<ResourceAccess> Reads;
+        std::vector<ResourceAccess> Writes;
+        bool HasSideEffects = false;
+        ExecuteFunction Execute;
+
+        bool IsAlive = false;
+        RenderGraphAccess Barrier = RenderGraphAccess::None;
+    };
+
+    struct Resource
+    {
+        std::string Name;
+        RenderGraphResourceType Type;
+        RenderGraphTextureDesc TextureDesc;
+        RenderGraphBufferDesc BufferDesc;
+        bool IsImported = false;
+        uint32_t ImportedHandle = 0;
+        RenderGraphResource LatestVersion = InvalidRenderGraphResource;
+
+        uint32_t FirstUse = UINT32_MAX;
+        uint32_t LastUse = 0;
+        uint32_t PhysicalSlot = InvalidRenderGraphResource;
+    };
+
+    struct PhysicalSlot
+    {
+        RenderGraphResourceType Type;
+        RenderGraphTextureDesc TextureDesc;
+        RenderGraphBufferDesc BufferDesc;
+        uint32_t LastUse = 0;
+        uint32_t Handle = 0;
+    };
+
+    // GL objects backing physical slots, kept around across frames
+    struct PooledResource
+    {
+        RenderGraphResourceType Type;
+        RenderGraphTextureDesc TextureDesc;
+        RenderGraphBufferDesc BufferDesc;
+        uint32_t Handle = 0;
+        uint64_t LastUsedFrame = 0;
+        bool IsInUse = false;
+    };
+
+    static size_t GetResourceSize(const Resource& resource);
+    RenderGraphResource AddResource(Resource resource);
+
+    bool SortPasses();
+    void CullPasses();
+    void ComputeLifetimes();
+    void AliasResources();
+    void BatchBarriers();
+
+    void AcquirePhysicalResources();
+    void ReleaseUnusedPhysicalResources();
+
+    std::vector<Pass> _passes;
+    std::vector<Resource> _resources;
+    std::vector<ResourceVersion> _versions;
+    std::vector<uint32_t> _executionOrder;
+    std::vector<PhysicalSlot> _physicalSlots;
+    std::vector<PooledResource> _pool;
+    RenderGraphStats _stats;
+    uint64_t _frameIndex = 0;
+    bool _hasErrors = false;
+    bool _isCompiled = false;
+};
+
+class RenderGraphBuilder
+{
+public:
+    void Read(RenderGraphResource resource, RenderGraphAccess access);
+    // Only the latest version of a resource can be written, returns the new version.
+    // Writing does not imply reading, declare a Read too when the pass loads previous contents (blending, depth testing)
+    [[nodiscard]] RenderGraphResource Write(RenderGraphResource resource, RenderGraphAccess access);
+    // Keep the pass even though nothing reads what it writes, e.g. readbacks or queries
+    void HasSideEffects();
+
+private:
+    friend class RenderGraph;
+    RenderGraphBuilder(RenderGraph& graph, uint32_t passIndex);
+
+    RenderGraph& _graph;
+    uint32_t _passIndex;
+};
+
+class RenderGraphContext
+{
+public:
+    [[nodiscard]] uint32_t GetTexture(RenderGraphResource resource) const;
+    [[nodiscard]] uint32_t GetBuffer(RenderGraphResource resource) const;
+    [[nodiscard]] const RenderGraphTextureDesc& GetTextureDesc(RenderGraphResource resource) const;
+
+private:
+    friend class RenderGraph;
+    explicit RenderGraphContext(const RenderGraph& graph);
+
+    uint32_t GetHandle(RenderGraphResource resource) const;
+
+    const RenderGraph& _graph;
+};
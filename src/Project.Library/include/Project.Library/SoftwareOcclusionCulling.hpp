@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+struct OccluderMesh
+{
+    const glm::vec3* Positions = nullptr;
+    const uint32_t* Indices = nullptr;
+    uint32_t IndexCount = 0;
+    int32_t BaseVertex = 0;
+    glm::mat4 WorldViewProjection = glm::mat4(1.0f);
+};
+
+enum class OcclusionTestResult : uint8_t
+{
+    Visible,
+    OutsideFrustum,
+    Occluded
+};
+
+struct SoftwareOcclusionStatistics
+{
+    uint32_t Occluders = 0;
+    uint32_t SubmittedTriangles = 0;
+    // what is left after near plane, guard band, backface and size rejection
+    uint32_t RasterizedTriangles = 0;
+    float RasterizationMilliseconds = 0.0f;
+    float TrianglesPerMillisecond = 0.0f;
+};
+
+// Low resolution depth buffer rasterized on the CPU from a few large occluders,
+// bounds are tested against it without waiting on the GPU.
+//
+// Triangles are set up once in 28.4 fixed point and binned into tiles, tiles are
+// rasterized in parallel, 8 pixels at a time on CPUs with AVX2. The depth of a
+// pixel is evaluated from the triangle's depth plane with the same float operations
+// on every path, so Rasterize and RasterizeReference produce identical buffers.
+// Occluders are never clipped: triangles crossing the near plane or leaving the
+// guard band are dropped, which only makes culling less aggressive.
+class SoftwareOcclusionCulling
+{
+public:
+    static constexpr uint32_t TileWidth = 64;
+    static constexpr uint32_t TileHeight = 32;
+
+    // Rounded up to whole tiles
+    explicit SoftwareOcclusionCulling(uint32_t width = 256, uint32_t height = 128);
+
+    // Both replace the whole depth buffer
+    void Rasterize(std::span<const OccluderMesh> occluders, ThreadPool& threadPool);
+    // Single threaded, untiled and scalar
+    void RasterizeReference(std::span<const OccluderMesh> occluders);
+
+    [[nodiscard]] OcclusionTestResult Test(
+        const glm::mat4& worldViewProjection,
+        const glm::vec3& boundsMin,
+        const glm::vec3& boundsMax) const;
+
+    // Fraction of the screen covered by the projected bounds, 1 when they cross the near plane
+    [[nodiscard]] static float GetScreenCoverage(
+        const glm::mat4& worldViewProjection,
+        const glm::vec3& boundsMin,
+        const glm::vec3& boundsMax);
+
+    [[nodiscard]] uint32_t GetWidth() const;
+    [[nodiscard]] uint32_t GetHeight() const;
+    // Row major, bottom row first, 1 is the far plane
+    [[nodiscard]] const std::vector<float>& GetDepth() const;
+    [[nodiscard]] const SoftwareOcclusionStatistics& GetStatistics() const;
+    // Built with PROJECT_ENABLE_AVX2 and running on a CPU that has it
+    [[nodiscard]] static bool IsAvx2Enabled();
+
+private:
+    struct Triangle
+    {
+        // 28.4 fixed point screen space
+        int32_t X[3];
+        int32_t Y[3];
+        // depth = DepthA * x + DepthB * y + DepthC at pixel centers
+        float DepthA;
+        float DepthB;
+        float DepthC;
+        // inclusive pixel bounds
+        int32_t MinX;
+        int32_t MinY;
+        int32_t MaxX;
+        int32_t MaxY;
+    };
+
+    void SetupTriangles(const OccluderMesh& occluder, std::vector<Triangle>& triangles) const;
+    void RasterizeTriangle(const Triangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY);
+    void RasterizeTriangleAvx2(const Triangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY);
+    void RasterizeTriangleScalar(const Triangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY);
+    void UpdateStatistics(std::span<const OccluderMesh> occluders, uint32_t rasterizedTriangles, float milliseconds);
+
+    uint32_t _width;
+    uint32_t _height;
+    uint32_t _tilesX;
+    uint32_t _tilesY;
+    std::vector<float> _depth;
+
+    // per thread, reused across frames
+    std::vector<std::vector<Triangle>> _threadTriangles;
+    std::vector<std::vector<std::vector<uint32_t>>> _threadBins;
+
+    SoftwareOcclusionStatistics _statistics;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Project.Library/Ktx2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct TextureMemoryStatistics
+{
+    uint32_t Textures = 0;
+    uint32_t CompressedTextures = 0;
+    // textures whose requested level is not resident yet
+    uint32_t StreamingTextures = 0;
+    // what the same textures would take as RGBA8 with a full mip chain
+    size_t UncompressedBytes = 0;
+    // immutable storage, every level of every texture
+    size_t AllocatedBytes = 0;
+    // levels uploaded so far
+    size_t ResidentBytes = 0;
+    // requested levels still waiting for upload budget
+    size_t PendingBytes = 0;
+    size_t UploadedBytes = 0;
+};
+
+// Owns textures loaded from KTX2 files and streams their mip chains in.
+//
+// Storage for every level is allocated up front, GL has no way to grow an immutable
+// texture short of sparse textures. The small levels up to TailSize are uploaded on
+// load, larger ones are uploaded coarse to fine once something on screen asks for
+// them, GL_TEXTURE_BASE_LEVEL keeps sampling on levels which are resident already.
+// Level data stays in system memory until the whole chain is resident.
+class TextureStreamer
+{
+public:
+    static constexpr uint32_t TailSize = 128;
+
+    TextureStreamer() = default;
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Returns 0 if the file can't be read or the GL implementation lacks the format
+    uint32_t CreateTexture(std::string_view filePath);
+    // Only accounts for a fully resident RGBA8 texture created elsewhere
+    void TrackTexture(uint32_t texture, uint32_t width, uint32_t height, uint32_t levels);
+    void Release();
+
+    // The texture spans about this many pixels on screen this frame, the largest request wins.
+    // Requests are reset by Update, so they have to be made every frame
+    void RequestScreenSize(uint32_t texture, float pixels);
+    // Uploads requested levels until the budget is used up, at least one level per call
+    void Update(size_t uploadBudget);
+
+    [[nodiscard]] const TextureMemoryStatistics& GetStatistics() const;
+
+    // The finest level a texture spanning this many pixels needs, one texel per pixel or more
+    [[nodiscard]] static uint32_t GetLevelForScreenSize(uint32_t width, uint32_t height, uint32_t levelCount, float pixels);
+    // RGBA8, for comparison with what is actually allocated
+    [[nodiscard]] static size_t GetUncompressedSize(uint32_t width, uint32_t height, uint32_t levels);
+
+private:
+    struct StreamedTexture
+    {
+        uint32_t Handle = 0;
+        bool IsStreamed = false;
+        Ktx2Image Image;
+        uint32_t LevelCount = 0;
+        uint32_t ResidentLevel = 0;
+        uint32_t RequestedLevel = 0;
+        size_t AllocatedBytes = 0;
+        size_t UncompressedBytes = 0;
+        size_t ResidentBytes = 0;
+    };
+
+    void UploadLevel(StreamedTexture& texture, uint32_t level);
+    void UpdateStatistics(size_t uploadedBytes);
+
+    std::vector<StreamedTexture> _textures;
+    std::unordered_map<uint32_t, size_t> _textureIndices;
+    TextureMemoryStatistics _statistics;
+};
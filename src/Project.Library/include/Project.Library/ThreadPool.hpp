@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops. The calling thread
+// works on chunks too, ParallelFor is not reentrant.
+class ThreadPool
+{
+public:
+    using ChunkFunction = std::function<void(uint32_t begin, uint32_t end, uint32_t threadIndex)>;
+
+    // 0 picks one worker less than there are hardware threads
+    explicit ThreadPool(uint32_t workerCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Workers plus the calling thread, threadIndex passed to chunks is below this
+    [[nodiscard]] uint32_t GetThreadCount() const;
+
+    // Splits [0, count) into chunks of chunkSize and returns once all of them ran
+    void ParallelFor(uint32_t count, uint32_t chunkSize, const ChunkFunction& function);
+
+private:
+    void WorkerMain(uint32_t threadIndex);
+    void RunChunks(uint32_t threadIndex);
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wakeCondition;
+    std::condition_variable _doneCondition;
+    uint64_t _generation = 0;
+    uint32_t _busyWorkers = 0;
+    bool _isStopping = false;
+
+    const ChunkFunction* _function = nullptr;
+    uint32_t _count = 0;
+    uint32_t _chunkSize = 0;
+    uint32_t _chunkCount = 0;
+    std::atomic<uint32_t> _nextChunk = 0;
+};
@@ -0,0 +1,113 @@
+#include <Project.Library/ClusteredLighting.hpp>
+#include <Project.Library/ThreadPool.hpp>
+#include <Project.Tests/Check.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+constexpr float NearPlane = 0.1f;
+constexpr float FarPlane = 256.0f;
+
+// Lights all around the camera, behind it and across the near and far plane included
+static std::vector<LightData> CreateLights(uint32_t lightCount, float extent)
+{
+    std::mt19937 random(lightCount);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<LightData> lights(lightCount);
+    for (auto& light : lights)
+    {
+        light.Position = glm::vec3(unit(random), unit(random), unit(random)) * extent;
+        light.Range = 0.05f + (unit(random) + 1.0f) * extent * 0.05f;
+        if (random() % 4 == 0)
+        {
+            light.Direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)));
+            light.SpotOuterCos = 0.3f + (unit(random) + 1.0f) * 0.3f;
+            light.SpotInnerCos = light.SpotOuterCos + 0.05f;
+        }
+    }
+    return lights;
+}
+
+static void TestMatchesReference(uint32_t tilesX, uint32_t tilesY, uint32_t slices, float aspectRatio, ThreadPool& threadPool)
+{
+    const auto projection = glm::perspective(glm::radians(80.0f), aspectRatio, NearPlane, FarPlane);
+    const auto view = glm::lookAt(glm::vec3(3.0f, 2.0f, -3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    ClusteredLighting clusteredLighting(tilesX, tilesY, slices);
+    ClusteredLighting reference(tilesX, tilesY, slices);
+    clusteredLighting.SetProjection(projection, NearPlane, FarPlane);
+    reference.SetProjection(projection, NearPlane, FarPlane);
+
+    for (const auto lightCount : { 0u, 1u, 100u, 10000u })
+    {
+        for (const auto extent : { 4.0f, 40.0f, 300.0f })
+        {
+            const auto lights = CreateLights(lightCount, extent);
+            clusteredLighting.Assign(lights, view, threadPool);
+            reference.AssignReference(lights, view);
+
+            Check(clusteredLighting.GetClusters() == reference.GetClusters(), "Assign and AssignReference produce the same ranges");
+            Check(clusteredLighting.GetLightIndices() == reference.GetLightIndices(), "Assign and AssignReference produce the same indices");
+            Check(clusteredLighting.GetStatistics().LightIndices == reference.GetStatistics().LightIndices, "same statistics");
+            if (lightCount == 10000 && extent == 40.0f)
+            {
+                Check(clusteredLighting.GetStatistics().LightIndices > 0, "lights touch clusters");
+            }
+        }
+    }
+
+    // lists are sorted by light index so shading order does not depend on the thread count
+    const auto& indices = clusteredLighting.GetLightIndices();
+    auto isSorted = true;
+    for (const auto& cluster : clusteredLighting.GetClusters())
+    {
+        isSorted &= std::is_sorted(indices.begin() + cluster.Offset, indices.begin() + cluster.Offset + cluster.Count);
+    }
+    Check(isSorted, "every cluster's list is sorted");
+}
+
+static void TestSingleLight(ThreadPool& threadPool)
+{
+    const auto projection = glm::perspective(glm::radians(90.0f), 1.0f, NearPlane, FarPlane);
+    ClusteredLighting clusteredLighting(4, 4, 16);
+    clusteredLighting.SetProjection(projection, NearPlane, FarPlane);
+
+    // small point light straight ahead, right where four tiles meet
+    LightData light;
+    light.Position = glm::vec3(0.0f, 0.0f, -10.0f);
+    light.Range = 0.5f;
+    const std::vector<LightData> lights = { light };
+    clusteredLighting.Assign(lights, glm::mat4(1.0f), threadPool);
+
+    const auto slice = static_cast<uint32_t>(std::floor(std::log(10.0f) * clusteredLighting.GetSliceScale() + clusteredLighting.GetSliceBias()));
+    const auto& clusters = clusteredLighting.GetClusters();
+    for (uint32_t tileY = 1; tileY <= 2; ++tileY)
+    {
+        for (uint32_t tileX = 1; tileX <= 2; ++tileX)
+        {
+            Check(clusters[(slice * 4 + tileY) * 4 + tileX].Count == 1, "the light reaches the center tiles of its slice");
+        }
+    }
+    Check(clusters[(slice * 4 + 0) * 4 + 0].Count == 0, "the light does not reach the corner tile");
+
+    // behind the camera nothing is lit
+    light.Position = glm::vec3(0.0f, 0.0f, 10.0f);
+    const std::vector<LightData> behind = { light };
+    clusteredLighting.Assign(behind, glm::mat4(1.0f), threadPool);
+    Check(clusteredLighting.GetLightIndices().empty(), "lights behind the camera are not assigned");
+}
+
+int main()
+{
+    ThreadPool threadPool;
+    TestMatchesReference(16, 9, 24, 16.0f / 9.0f, threadPool);
+    // widths that are no multiple of the vector width leave a remainder in every row
+    TestMatchesReference(15, 7, 20, 2.0f, threadPool);
+    TestMatchesReference(1, 1, 1, 1.0f, threadPool);
+    TestMatchesReference(33, 3, 64, 4.0f, threadPool);
+    TestSingleLight(threadPool);
+    return GetTestResult("ClusteredLighting");
+}
@@ -0,0 +1,122 @@
+#include <Project.Library/DrawQueue.hpp>
+#include <Project.Library/ThreadPool.hpp>
+#include <Project.Tests/Check.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+static_assert(DrawSortKey::PassShift + DrawSortKey::PassBits == 64, "the key fields fill 64 bits");
+static_assert(DrawSortKey::GetPass(DrawSortKey::Make(3, 7, 123456, 99)) == 3);
+static_assert(DrawSortKey::GetProgram(DrawSortKey::Make(3, 7, 123456, 99)) == 7);
+static_assert(DrawSortKey::GetMaterial(DrawSortKey::Make(3, 7, 123456, 99)) == 123456);
+static_assert(DrawSortKey::GetDepth(DrawSortKey::Make(3, 7, 123456, 99)) == 99);
+static_assert(DrawSortKey::GetProgram(DrawSortKey::Make(0, 0x1001, 0, 0)) == 1, "wider fields are truncated");
+
+// keys shaped like draw sort keys share most of their high bits, so digit passes get skipped
+static std::vector<uint64_t> CreateKeys(uint32_t count, uint32_t seed, bool isDrawSortKey)
+{
+    std::mt19937_64 random(seed);
+    std::vector<uint64_t> keys(count);
+    for (auto& key : keys)
+    {
+        key = isDrawSortKey
+            ? DrawSortKey::Make(random() % 3, random() % 16, random() % 4096, static_cast<uint32_t>(random() % 64))
+            : random();
+    }
+    return keys;
+}
+
+// Compares against std::stable_sort over key and original index, which also checks stability
+static void TestMatchesStableSort(uint32_t count, uint32_t seed, bool isDrawSortKey, ThreadPool& threadPool)
+{
+    auto keys = CreateKeys(count, seed, isDrawSortKey);
+    std::vector<std::pair<uint64_t, uint32_t>> expected(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        expected[i] = { keys[i], i };
+    }
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    std::vector<uint32_t> values(count);
+    std::iota(values.begin(), values.end(), 0);
+    RadixSorter sorter;
+    sorter.Sort(keys, values, threadPool);
+
+    auto isMatching = true;
+    for (uint32_t i = 0; i < count && isMatching; ++i)
+    {
+        isMatching = keys[i] == expected[i].first && values[i] == expected[i].second;
+    }
+    Check(isMatching, "radix sort matches std::stable_sort");
+    Check(sorter.GetScatterPassCount() <= 8, "at most one scatter per digit");
+
+    // keys only, without values to carry along
+    auto keysOnly = CreateKeys(count, seed, isDrawSortKey);
+    sorter.Sort(keysOnly, {}, threadPool);
+    Check(std::is_sorted(keysOnly.begin(), keysOnly.end()), "keys without values are sorted");
+}
+
+static void TestSkippedPasses(ThreadPool& threadPool)
+{
+    RadixSorter sorter;
+    std::vector<uint64_t> sameKeys(1000, 0x1234567812345678ull);
+    std::vector<uint32_t> values(1000);
+    std::iota(values.begin(), values.end(), 0);
+    sorter.Sort(sameKeys, values, threadPool);
+    Check(sorter.GetScatterPassCount() == 0, "equal keys need no scatter");
+    Check(std::is_sorted(values.begin(), values.end()), "equal keys keep their order");
+
+    // only the lowest byte differs
+    std::vector<uint64_t> lowByteKeys(1000);
+    for (uint32_t i = 0; i < lowByteKeys.size(); ++i)
+    {
+        lowByteKeys[i] = 0xFF00000000000000ull | ((i * 37) & 0xFF);
+    }
+    sorter.Sort(lowByteKeys, {}, threadPool);
+    Check(sorter.GetScatterPassCount() == 1, "constant digits are skipped");
+    Check(std::is_sorted(lowByteKeys.begin(), lowByteKeys.end()), "low byte keys are sorted");
+}
+
+static void TestQuantizeDepth()
+{
+    Check(DrawSortKey::QuantizeDepth(0.0f) == 0, "near plane is the first bucket");
+    Check(DrawSortKey::QuantizeDepth(1.0f) == (1u << DrawSortKey::DepthBits) - 1, "far plane is the last bucket");
+    Check(DrawSortKey::QuantizeDepth(-1.0f) == 0 && DrawSortKey::QuantizeDepth(2.0f) == DrawSortKey::QuantizeDepth(1.0f), "depth is clamped");
+    Check(DrawSortKey::QuantizeDepth(0.25f) < DrawSortKey::QuantizeDepth(0.75f), "front to back");
+    Check(DrawSortKey::QuantizeDepth(0.25f, true) > DrawSortKey::QuantizeDepth(0.75f, true), "back to front");
+}
+
+static void TestDrawQueue(ThreadPool& threadPool)
+{
+    DrawQueue queue;
+    queue.Add(DrawSortKey::Make(1, 0, 0, 5), 0);
+    queue.Add(DrawSortKey::Make(0, 2, 0, 9), 1);
+    queue.Add(DrawSortKey::Make(0, 1, 3, 7), 2);
+    queue.Add(DrawSortKey::Make(0, 1, 3, 2), 3);
+    queue.Sort(threadPool);
+
+    const std::vector<uint32_t> expected = { 3, 2, 1, 0 };
+    const auto items = queue.GetItems();
+    Check(queue.GetSize() == 4, "queue size");
+    Check(std::equal(items.begin(), items.end(), expected.begin(), expected.end()), "items follow pass, program, material and depth");
+
+    queue.Clear();
+    Check(queue.GetSize() == 0, "Clear empties the queue");
+}
+
+int main()
+{
+    ThreadPool threadPool;
+    for (const auto count : { 0u, 1u, 2u, 5u, 1000u, 16385u, 100000u, 1u << 20 })
+    {
+        TestMatchesStableSort(count, count, false, threadPool);
+        TestMatchesStableSort(count, count + 1, true, threadPool);
+    }
+    TestSkippedPasses(threadPool);
+    TestQuantizeDepth();
+    TestDrawQueue(threadPool);
+    return GetTestResult("DrawQueue");
+}
@@ -0,0 +1,114 @@
+#include <Project.Library/FramePacer.hpp>
+#include <Project.Tests/Check.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static bool IsNear(float value, float expected)
+{
+    return std::abs(value - expected) < 1e-4f;
+}
+
+static void TestPercentiles()
+{
+    // 0.5ms bins, one sample in the middle of each of the first 100
+    FrameHistogram histogram(100.0f, 200);
+    Check(histogram.GetPercentile(50.0f) == 0.0f, "an empty histogram has no percentiles");
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        histogram.Add(static_cast<float>(i) * 0.5f + 0.25f);
+    }
+
+    Check(histogram.GetSampleCount() == 100, "every sample is counted");
+    Check(IsNear(histogram.GetPercentile(50.0f), 25.0f), "p50 is the upper edge of the 50th bin");
+    Check(IsNear(histogram.GetPercentile(95.0f), 47.5f), "p95 is the upper edge of the 95th bin");
+    Check(IsNear(histogram.GetPercentile(99.0f), 49.5f), "p99 is the upper edge of the 99th bin");
+    Check(IsNear(histogram.GetPercentile(100.0f), 50.0f), "p100 is the upper edge of the last used bin");
+
+    histogram.Reset();
+    Check(histogram.GetSampleCount() == 0 && histogram.GetPercentile(50.0f) == 0.0f, "reset clears all samples");
+}
+
+static void TestOverflow()
+{
+    FrameHistogram histogram(100.0f, 200);
+    histogram.Add(250.0f);
+    histogram.Add(100.0f);
+    histogram.Add(-3.0f);
+
+    const auto& bins = histogram.GetBins();
+    Check(bins.back() == 2.0f, "samples at and above the maximum go into the last bin");
+    Check(bins.front() == 1.0f, "negative samples go into the first bin");
+    Check(IsNear(histogram.GetPercentile(100.0f), 100.0f), "overflowing samples report the maximum");
+    Check(IsNear(histogram.GetPercentile(30.0f), 0.5f), "the lowest third stays in the first bin");
+}
+
+static std::vector<uint64_t> ReadCsvFrames(const FramePacer& framePacer)
+{
+    std::ostringstream stream;
+    framePacer.WriteCsv(stream);
+
+    std::istringstream csv(stream.str());
+    std::string line;
+    std::getline(csv, line);
+    Check(line.rfind("frame,", 0) == 0, "the history starts with its header");
+
+    // the history ends at the blank line before the histograms
+    std::vector<uint64_t> frames;
+    while (std::getline(csv, line) && !line.empty())
+    {
+        frames.push_back(std::stoull(line.substr(0, line.find(','))));
+    }
+    Check(std::getline(csv, line) && line.rfind("bin_start_ms,", 0) == 0, "the histograms follow the history");
+    return frames;
+}
+
+static void AddFrames(FramePacer& framePacer, uint64_t firstFrame, uint64_t frameCount)
+{
+    for (auto frame = firstFrame; frame < firstFrame + frameCount; ++frame)
+    {
+        FrameRecord record;
+        record.Frame = frame;
+        record.FrameMilliseconds = 16.0f;
+        record.CpuMilliseconds = 4.0f;
+        record.GpuMilliseconds = 8.0f;
+        record.LatencyMilliseconds = 20.0f;
+        framePacer.AddCompletedFrame(record);
+    }
+}
+
+static void TestHistoryOrder()
+{
+    FramePacer framePacer;
+    AddFrames(framePacer, 0, 5);
+    auto frames = ReadCsvFrames(framePacer);
+    Check(frames == std::vector<uint64_t>{ 0, 1, 2, 3, 4 }, "a partial history is written in order");
+    // the first frame has no previous input sample to measure from
+    Check(framePacer.GetFrameTimeHistogram().GetSampleCount() == 4, "the first frame has no frame time");
+    Check(framePacer.GetLatencyHistogram().GetSampleCount() == 5, "every frame has a latency");
+    Check(framePacer.GetStatistics().LastFrame.Frame == 4, "the last frame is reported");
+
+    // wraps the ring, the oldest remaining frame is overwritten last
+    constexpr uint64_t Wrapped = 10;
+    AddFrames(framePacer, 5, FramePacer::HistorySize + Wrapped - 5);
+    frames = ReadCsvFrames(framePacer);
+    Check(frames.size() == FramePacer::HistorySize, "a wrapped history keeps its size");
+
+    auto isOrdered = true;
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        isOrdered &= frames[i] == Wrapped + i;
+    }
+    Check(isOrdered, "a wrapped history is written oldest first");
+}
+
+int main()
+{
+    TestPercentiles();
+    TestOverflow();
+    TestHistoryOrder();
+    return GetTestResult("FramePacer");
+}
@@ -0,0 +1,377 @@
+#include <Project.Library/Ktx2.hpp>
+#include <Project.Library/TextureStreamer.hpp>
+#include <Project.TextureCompressor/BlockCompression.hpp>
+#include <Project.Tests/Check.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Byte offsets into the file, the header and level index layout is fixed by the spec
+constexpr size_t LevelCountOffset = 40;
+constexpr size_t SupercompressionOffset = 44;
+constexpr size_t LevelIndexOffset = 80;
+constexpr size_t LevelIndexSize = 24;
+
+// Full mip chain of random texels, compressed the way the texture compressor does it
+static Ktx2Image CreateImage(Ktx2Format format, uint32_t width, uint32_t height, uint32_t seed)
+{
+    Ktx2Image image;
+    image.FormatInfo = *GetKtx2FormatInfo(format);
+    image.Width = width;
+    image.Height = height;
+
+    std::mt19937 random(seed);
+    const auto levelCount = static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        const auto levelWidth = std::max(width >> level, 1u);
+        const auto levelHeight = std::max(height >> level, 1u);
+        std::vector<uint8_t> texels(static_cast<size_t>(levelWidth) * levelHeight * 4);
+        for (auto& texel : texels)
+        {
+            texel = static_cast<uint8_t>(random());
+        }
+
+        const auto levelData = CompressLevel(image.FormatInfo, texels.data(), levelWidth, levelHeight);
+        image.Levels.push_back({ levelWidth, levelHeight, image.Data.size(), levelData.size() });
+        image.Data.insert(image.Data.end(), levelData.begin(), levelData.end());
+    }
+    return image;
+}
+
+static uint64_t ReadUint64(const std::vector<uint8_t>& file, size_t offset)
+{
+    uint64_t value = 0;
+    std::memcpy(&value, file.data() + offset, sizeof(value));
+    return value;
+}
+
+static void WriteUint32(std::vector<uint8_t>& file, size_t offset, uint32_t value)
+{
+    std::memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+static void WriteUint64(std::vector<uint8_t>& file, size_t offset, uint64_t value)
+{
+    std::memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+static void TestRoundTrip(Ktx2Format format, uint32_t width, uint32_t height)
+{
+    const auto image = CreateImage(format, width, height, width * 131 + height);
+    std::vector<uint8_t> file;
+    Check(WriteKtx2(image, file), "WriteKtx2");
+
+    Ktx2Image readImage;
+    Check(ReadKtx2(file, readImage), "ReadKtx2 reads what WriteKtx2 wrote");
+    Check(readImage.FormatInfo.Format == format && readImage.FormatInfo.GLFormat == image.FormatInfo.GLFormat, "same format");
+    Check(readImage.Width == width && readImage.Height == height, "same size");
+    Check(readImage.Data == image.Data, "same level data");
+    Check(readImage.Levels.size() == image.Levels.size(), "same level count");
+    for (size_t level = 0; level < std::min(readImage.Levels.size(), image.Levels.size()); ++level)
+    {
+        const auto& expected = image.Levels[level];
+        const auto& actual = readImage.Levels[level];
+        Check(actual.Width == expected.Width && actual.Height == expected.Height, "same level size");
+        Check(actual.Offset == expected.Offset && actual.Size == expected.Size, "same level range");
+        Check(actual.Size == GetKtx2LevelSize(image.FormatInfo, expected.Width, expected.Height), "level size covers partial blocks");
+    }
+    Check(readImage.Levels[0].Offset == 0, "level 0 comes first in memory");
+
+    // in the file the smallest level comes first, so level 0 ends the file, every level aligned
+    const auto alignment = std::max(image.FormatInfo.BlockBytes, 4u);
+    const auto levelCount = image.Levels.size();
+    for (size_t level = 0; level < levelCount; ++level)
+    {
+        const auto byteOffset = ReadUint64(file, LevelIndexOffset + level * LevelIndexSize);
+        Check(byteOffset % alignment == 0, "levels are aligned");
+        if (level + 1 < levelCount)
+        {
+            Check(byteOffset > ReadUint64(file, LevelIndexOffset + (level + 1) * LevelIndexSize), "smaller levels come first");
+        }
+    }
+    Check(ReadUint64(file, LevelIndexOffset) + image.Levels[0].Size == file.size(), "level 0 ends the file");
+}
+
+static void TestRejection()
+{
+    const auto image = CreateImage(Ktx2Format::Bc1RgbUnorm, 13, 7, 1);
+    std::vector<uint8_t> file;
+    Check(WriteKtx2(image, file), "WriteKtx2");
+    Ktx2Image readImage;
+
+    // every cut falls into the header, the level index or the level data
+    for (const auto size : { size_t(0), size_t(40), LevelIndexOffset + 10, LevelIndexOffset + LevelIndexSize * 2, file.size() - 1 })
+    {
+        const std::vector<uint8_t> truncated(file.begin(), file.begin() + static_cast<ptrdiff_t>(size));
+        Check(!ReadKtx2(truncated, readImage), "truncated files are rejected");
+    }
+
+    auto badIdentifier = file;
+    badIdentifier[1] = 'X';
+    Check(!ReadKtx2(badIdentifier, readImage), "wrong identifier is rejected");
+
+    auto supercompressed = file;
+    WriteUint32(supercompressed, SupercompressionOffset, 2);
+    Check(!ReadKtx2(supercompressed, readImage), "supercompression is rejected");
+
+    auto unknownFormat = file;
+    WriteUint32(unknownFormat, 12, 1000);
+    Check(!ReadKtx2(unknownFormat, readImage), "unknown formats are rejected");
+
+    // 13x7 has four levels, a fifth would be smaller than 1x1
+    auto tooManyLevels = file;
+    WriteUint32(tooManyLevels, LevelCountOffset, 5);
+    Check(!ReadKtx2(tooManyLevels, readImage), "more levels than the size allows are rejected");
+
+    auto offsetPastEnd = file;
+    WriteUint64(offsetPastEnd, LevelIndexOffset + LevelIndexSize, file.size());
+    Check(!ReadKtx2(offsetPastEnd, readImage), "levels starting past the end are rejected");
+
+    // the offset and length each fit in the file, their sum does not
+    auto lengthPastEnd = file;
+    WriteUint64(lengthPastEnd, LevelIndexOffset, file.size() - 8);
+    Check(!ReadKtx2(lengthPastEnd, readImage), "levels running past the end are rejected");
+
+    auto wrongLength = file;
+    WriteUint64(wrongLength, LevelIndexOffset + 8, image.Levels[0].Size - 8);
+    Check(!ReadKtx2(wrongLength, readImage), "levels of the wrong size are rejected");
+
+    auto overflowingOffset = file;
+    WriteUint64(overflowingOffset, LevelIndexOffset, UINT64_MAX - 4);
+    Check(!ReadKtx2(overflowingOffset, readImage), "offsets that wrap around are rejected");
+
+    Check(ReadKtx2(file, readImage), "the untouched file still reads");
+}
+
+// The same bit replication and interpolation the hardware does
+static std::array<uint8_t, 64> DecodeBc1Block(const uint8_t* block)
+{
+    uint16_t colors[2];
+    uint32_t indices = 0;
+    std::memcpy(colors, block, sizeof(colors));
+    std::memcpy(&indices, block + 4, sizeof(indices));
+
+    std::array<std::array<int32_t, 3>, 4> palette = {};
+    for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+    {
+        const auto r = (colors[endpoint] >> 11) & 31;
+        const auto g = (colors[endpoint] >> 5) & 63;
+        const auto b = colors[endpoint] & 31;
+        palette[endpoint] = { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+    }
+    for (uint32_t channel = 0; channel < 3; ++channel)
+    {
+        if (colors[0] > colors[1])
+        {
+            palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+            palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+        }
+        else
+        {
+            palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+        }
+    }
+
+    std::array<uint8_t, 64> texels = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        const auto& color = palette[(indices >> (i * 2)) & 3];
+        texels[i * 4 + 0] = static_cast<uint8_t>(color[0]);
+        texels[i * 4 + 1] = static_cast<uint8_t>(color[1]);
+        texels[i * 4 + 2] = static_cast<uint8_t>(color[2]);
+        texels[i * 4 + 3] = 255;
+    }
+    return texels;
+}
+
+static std::array<uint8_t, 16> DecodeBc4Block(const uint8_t* block)
+{
+    const auto value0 = static_cast<int32_t>(block[0]);
+    const auto value1 = static_cast<int32_t>(block[1]);
+    std::array<int32_t, 8> palette = { value0, value1 };
+    if (value0 > value1)
+    {
+        for (int32_t step = 1; step < 7; ++step)
+        {
+            palette[step + 1] = ((7 - step) * value0 + step * value1) / 7;
+        }
+    }
+    else
+    {
+        for (int32_t step = 1; step < 5; ++step)
+        {
+            palette[step + 1] = ((5 - step) * value0 + step * value1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (uint32_t byte = 0; byte < 6; ++byte)
+    {
+        indices |= static_cast<uint64_t>(block[2 + byte]) << (byte * 8);
+    }
+    std::array<uint8_t, 16> values = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        values[i] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+    }
+    return values;
+}
+
+static int32_t GetMaxBc1Error(const std::array<uint8_t, 64>& texels)
+{
+    std::array<uint8_t, 8> block;
+    CompressBc1Block(texels.data(), block.data());
+    const auto decoded = DecodeBc1Block(block.data());
+    int32_t maxError = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t channel = 0; channel < 3; ++channel)
+        {
+            maxError = std::max(maxError, std::abs(decoded[i * 4 + channel] - texels[i * 4 + channel]));
+        }
+    }
+    return maxError;
+}
+
+static void TestBc1()
+{
+    // the variation is orthogonal to grey, a grey start for the endpoint search flattens this block
+    std::array<uint8_t, 64> redGreen = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        redGreen[i * 4 + (i < 8 ? 0 : 1)] = 255;
+        redGreen[i * 4 + 3] = 255;
+    }
+    Check(GetMaxBc1Error(redGreen) == 0, "red against green survives exactly");
+
+    // 565 rounding is at most half a step, red and blue steps are about 8 apart
+    std::array<uint8_t, 64> flat = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        flat[i * 4 + 0] = 77;
+        flat[i * 4 + 1] = 140;
+        flat[i * 4 + 2] = 201;
+    }
+    Check(GetMaxBc1Error(flat) <= 4, "flat blocks only lose the 565 rounding");
+
+    // four evenly spaced colors on a line match the four color palette
+    std::array<uint8_t, 64> ramp = {};
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        const auto step = static_cast<int32_t>(i % 4);
+        ramp[i * 4 + 0] = static_cast<uint8_t>(255 - step * 85);
+        ramp[i * 4 + 1] = static_cast<uint8_t>(step * 85);
+        ramp[i * 4 + 2] = 0;
+    }
+    Check(GetMaxBc1Error(ramp) <= 2, "a four step ramp between exact endpoints survives");
+
+    // noisy blocks can't be exact, but the error stays within the block's own range
+    std::mt19937 random(7);
+    auto isBounded = true;
+    for (uint32_t blockIndex = 0; blockIndex < 1000; ++blockIndex)
+    {
+        std::array<uint8_t, 64> texels;
+        const auto base = static_cast<int32_t>(random() % 192);
+        const auto spread = static_cast<int32_t>(random() % 64) + 1;
+        for (auto& texel : texels)
+        {
+            texel = static_cast<uint8_t>(base + static_cast<int32_t>(random() % spread));
+        }
+        isBounded &= GetMaxBc1Error(texels) <= spread + 4;
+    }
+    Check(isBounded, "random blocks stay within their range");
+}
+
+static void TestBc4()
+{
+    std::mt19937 random(11);
+    auto isBounded = true;
+    auto isExactAtEndpoints = true;
+    for (uint32_t blockIndex = 0; blockIndex < 1000; ++blockIndex)
+    {
+        std::array<uint8_t, 64> texels = {};
+        for (auto& texel : texels)
+        {
+            texel = static_cast<uint8_t>(random());
+        }
+        // some blocks flat, some with a small range
+        if (blockIndex % 10 == 0)
+        {
+            std::fill(texels.begin(), texels.end(), texels[0]);
+        }
+        else if (blockIndex % 10 == 1)
+        {
+            for (auto& texel : texels)
+            {
+                texel = static_cast<uint8_t>(100 + texel % 9);
+            }
+        }
+
+        for (const auto channel : { 0u, 3u })
+        {
+            std::array<uint8_t, 8> block;
+            CompressBc4Block(texels.data(), channel, block.data());
+            const auto decoded = DecodeBc4Block(block.data());
+            int32_t minValue = 255;
+            int32_t maxValue = 0;
+            int32_t maxError = 0;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                const auto value = static_cast<int32_t>(texels[i * 4 + channel]);
+                minValue = std::min(minValue, value);
+                maxValue = std::max(maxValue, value);
+                maxError = std::max(maxError, std::abs(decoded[i] - value));
+            }
+            // half of the 1/7 palette step, plus one for the decoder rounding down
+            isBounded &= maxError * 14 <= maxValue - minValue + 14;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                const auto value = static_cast<int32_t>(texels[i * 4 + channel]);
+                if (value == minValue || value == maxValue)
+                {
+                    isExactAtEndpoints &= decoded[i] == value;
+                }
+            }
+        }
+    }
+    Check(isBounded, "BC4 error is at most half a palette step");
+    Check(isExactAtEndpoints, "BC4 keeps the block's minimum and maximum exactly");
+}
+
+static void TestStreamingLevels()
+{
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 11, 1024.0f) == 0, "full size needs level 0");
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 11, 512.0f) == 1, "half size needs level 1");
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 11, 300.0f) == 1, "in between takes the finer level");
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 11, 1.0f) == 10, "a pixel needs the last level");
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 11, 0.01f) == 10, "clamped to the last level");
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 11, 4096.0f) == 0, "magnified textures need level 0");
+    Check(TextureStreamer::GetLevelForScreenSize(1024, 512, 4, 1.0f) == 3, "clamped to the levels the file has");
+    Check(TextureStreamer::GetLevelForScreenSize(13, 7, 4, 3.0f) == 2, "sizes that are no power of two");
+
+    Check(TextureStreamer::GetUncompressedSize(4, 4, 3) == (16 + 4 + 1) * 4, "uncompressed size of a full chain");
+    Check(TextureStreamer::GetUncompressedSize(13, 7, 4) == (13 * 7 + 6 * 3 + 3 * 1 + 1 * 1) * 4, "uncompressed size of an odd chain");
+}
+
+int main()
+{
+    TestRoundTrip(Ktx2Format::Bc1RgbUnorm, 64, 64);
+    // sizes that are no multiple of the block size leave partial blocks in every level
+    TestRoundTrip(Ktx2Format::Bc1RgbSrgb, 13, 7);
+    TestRoundTrip(Ktx2Format::Bc3Unorm, 30, 2);
+    TestRoundTrip(Ktx2Format::Bc5Unorm, 1, 9);
+    TestRoundTrip(Ktx2Format::R8G8B8A8Unorm, 5, 3);
+    TestRejection();
+    TestBc1();
+    TestBc4();
+    TestStreamingLevels();
+    return GetTestResult("Ktx2");
+}
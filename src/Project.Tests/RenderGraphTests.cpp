@@ -0,0 +1,272 @@
+#include <Project.Library/RenderGraph.hpp>
+#include <Project.Tests/Check.hpp>
+
+#include <string_view>
+#include <vector>
+
+// GL internal formats by value, the tests do not pull in a GL loader
+constexpr uint32_t GLR8 = 0x8229;
+constexpr uint32_t GLRgba8 = 0x8058;
+constexpr uint32_t GLR32f = 0x822E;
+
+using Access = RenderGraphAccess;
+
+static bool IsPassOrder(const RenderGraph& graph, const std::vector<std::string_view>& expected)
+{
+    return graph.GetPassOrder() == expected;
+}
+
+static void TestOrdering()
+{
+    RenderGraph graph;
+    auto backbuffer = graph.ImportTexture("Backbuffer", 0);
+    auto depth = graph.CreateTexture("Depth", { 64, 64, GLR32f, 1 });
+    auto color = graph.CreateTexture("Color", { 64, 64, GLRgba8, 1 });
+
+    graph.AddPass("Depth", [&](RenderGraphBuilder& builder)
+    {
+        depth = builder.Write(depth, Access::Framebuffer);
+    }, {});
+    const auto depthAfterPrepass = depth;
+    graph.AddPass("Color", [&](RenderGraphBuilder& builder)
+    {
+        color = builder.Write(color, Access::Framebuffer);
+    }, {});
+    graph.AddPass("Resolve", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(depth, Access::TextureFetch);
+        builder.Read(color, Access::TextureFetch);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+    // overwrites the depth Resolve reads, so it has to wait for Resolve even though it is declared independent of it
+    graph.AddPass("DepthOverwrite", [&](RenderGraphBuilder& builder)
+    {
+        depth = builder.Write(depthAfterPrepass, Access::Framebuffer);
+        builder.HasSideEffects();
+    }, {});
+
+    Check(graph.Compile(), "Compile");
+    Check(IsPassOrder(graph, { "Depth", "Color", "Resolve", "DepthOverwrite" }), "dependency order with ties in declaration order");
+    Check(graph.GetStats().CulledPasses == 0, "no pass culled");
+}
+
+static void TestOutdatedWrite()
+{
+    RenderGraph graph;
+    auto texture = graph.CreateTexture("Texture", { 4, 4, GLR8, 1 });
+    const auto firstVersion = texture;
+    graph.AddPass("First", [&](RenderGraphBuilder& builder)
+    {
+        texture = builder.Write(texture, Access::Framebuffer);
+        builder.HasSideEffects();
+    }, {});
+    graph.AddPass("Second", [&](RenderGraphBuilder& builder)
+    {
+        Check(builder.Write(firstVersion, Access::Framebuffer) == InvalidRenderGraphResource, "writing an outdated version fails");
+    }, {});
+
+    Check(!graph.Compile(), "Compile fails after an invalid declaration");
+}
+
+static void TestCulling()
+{
+    RenderGraph graph;
+    auto backbuffer = graph.ImportTexture("Backbuffer", 0);
+    auto used = graph.CreateTexture("Used", { 16, 16, GLRgba8, 1 });
+    auto unread = graph.CreateTexture("Unread", { 16, 16, GLRgba8, 1 });
+    auto unreadInput = graph.CreateTexture("UnreadInput", { 16, 16, GLRgba8, 1 });
+    auto readback = graph.CreateBuffer("Readback", { 256 });
+
+    graph.AddPass("Used", [&](RenderGraphBuilder& builder)
+    {
+        used = builder.Write(used, Access::Framebuffer);
+    }, {});
+    graph.AddPass("UnreadInput", [&](RenderGraphBuilder& builder)
+    {
+        unreadInput = builder.Write(unreadInput, Access::Framebuffer);
+    }, {});
+    // only feeds a pass that is culled itself, so it goes as well
+    graph.AddPass("Unread", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(unreadInput, Access::TextureFetch);
+        unread = builder.Write(unread, Access::Framebuffer);
+    }, {});
+    graph.AddPass("Readback", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(used, Access::TextureFetch);
+        readback = builder.Write(readback, Access::PixelBuffer);
+        builder.HasSideEffects();
+    }, {});
+    graph.AddPass("Present", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(used, Access::TextureFetch);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+
+    Check(graph.Compile(), "Compile");
+    Check(IsPassOrder(graph, { "Used", "Readback", "Present" }), "passes nobody reads from are culled");
+    Check(graph.GetStats().DeclaredPasses == 5, "declared passes");
+    Check(graph.GetStats().CulledPasses == 2, "culled passes");
+    Check(graph.GetPhysicalSlot(unread) == InvalidRenderGraphResource, "culled resources get no allocation");
+    Check(graph.GetPhysicalSlot(unreadInput) == InvalidRenderGraphResource, "culled inputs get no allocation");
+}
+
+static void TestAliasingAndPeakMemory()
+{
+    constexpr RenderGraphTextureDesc desc = { 64, 32, GLRgba8, 1 };
+    const auto textureSize = RenderGraph::GetTextureSize(desc);
+    Check(textureSize == 64 * 32 * 4, "texture size");
+    Check(RenderGraph::GetTextureSize({ 64, 32, GLR32f, 3 }) == (64 * 32 + 32 * 16 + 16 * 8) * 4, "texture size with levels");
+
+    RenderGraph graph;
+    auto backbuffer = graph.ImportTexture("Backbuffer", 0);
+    auto first = graph.CreateTexture("First", desc);
+    auto second = graph.CreateTexture("Second", desc);
+    auto third = graph.CreateTexture("Third", desc);
+    auto other = graph.CreateTexture("Other", { 64, 32, GLR8, 1 });
+    auto smallBuffer = graph.CreateBuffer("SmallBuffer", { 1024 });
+    auto largeBuffer = graph.CreateBuffer("LargeBuffer", { 4096 });
+
+    graph.AddPass("First", [&](RenderGraphBuilder& builder)
+    {
+        first = builder.Write(first, Access::Framebuffer);
+        smallBuffer = builder.Write(smallBuffer, Access::StorageBuffer);
+    }, {});
+    graph.AddPass("Second", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(first, Access::TextureFetch);
+        builder.Read(smallBuffer, Access::StorageBuffer);
+        second = builder.Write(second, Access::Framebuffer);
+    }, {});
+    graph.AddPass("Third", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(second, Access::TextureFetch);
+        third = builder.Write(third, Access::Framebuffer);
+        other = builder.Write(other, Access::Framebuffer);
+        largeBuffer = builder.Write(largeBuffer, Access::StorageBuffer);
+    }, {});
+    graph.AddPass("Present", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(third, Access::TextureFetch);
+        builder.Read(other, Access::TextureFetch);
+        builder.Read(largeBuffer, Access::StorageBuffer);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+
+    Check(graph.Compile(), "Compile");
+    Check(graph.GetPhysicalSlot(first) == graph.GetPhysicalSlot(third), "disjoint lifetimes with matching descriptions alias");
+    Check(graph.GetPhysicalSlot(first) != graph.GetPhysicalSlot(second), "overlapping lifetimes do not alias");
+    Check(graph.GetPhysicalSlot(other) != graph.GetPhysicalSlot(first), "textures with different descriptions do not alias");
+    Check(graph.GetPhysicalSlot(smallBuffer) == graph.GetPhysicalSlot(largeBuffer), "buffers with disjoint lifetimes alias");
+    Check(graph.GetPhysicalSlot(backbuffer) == InvalidRenderGraphResource, "imported resources are not aliased");
+
+    const auto& stats = graph.GetStats();
+    const auto otherSize = RenderGraph::GetTextureSize({ 64, 32, GLR8, 1 });
+    Check(stats.TransientResources == 6, "transient resources");
+    Check(stats.PhysicalResources == 4, "physical resources");
+    Check(stats.TransientMemoryWithoutAliasing == textureSize * 3 + otherSize + 1024 + 4096, "memory without aliasing");
+    // the shared buffer is sized for the larger of the two
+    Check(stats.TransientMemoryWithAliasing == textureSize * 2 + otherSize + 4096, "memory with aliasing");
+    // at Third, Second, Third, Other and LargeBuffer are alive
+    Check(stats.PeakLiveTransientMemory == textureSize * 2 + otherSize + 4096, "peak live memory");
+    Check(stats.PeakLiveTransientMemory <= stats.TransientMemoryWithAliasing, "aliasing never beats the peak");
+
+    // Compiling again without a Reset has to give the same answer
+    const auto statsBefore = stats;
+    const auto slotBefore = graph.GetPhysicalSlot(third);
+    Check(graph.Compile(), "second Compile");
+    Check(graph.GetStats().PhysicalResources == statsBefore.PhysicalResources, "second Compile physical resources");
+    Check(graph.GetStats().TransientMemoryWithAliasing == statsBefore.TransientMemoryWithAliasing, "second Compile memory with aliasing");
+    Check(graph.GetStats().PeakLiveTransientMemory == statsBefore.PeakLiveTransientMemory, "second Compile peak live memory");
+    Check(graph.GetPhysicalSlot(third) == slotBefore, "second Compile slots");
+
+    // First now lives until the end, so it can no longer share with Third
+    graph.AddPass("Late", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(first, Access::TextureFetch);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+    Check(graph.Compile(), "Compile after adding a pass");
+    Check(graph.GetPhysicalSlot(first) != graph.GetPhysicalSlot(third), "lifetimes are recomputed instead of extended");
+    Check(graph.GetStats().PhysicalResources == 5, "physical resources after adding a pass");
+}
+
+static void TestBarriers()
+{
+    RenderGraph graph;
+    auto backbuffer = graph.ImportTexture("Backbuffer", 0);
+    auto image = graph.CreateTexture("Image", { 16, 16, GLR32f, 1 });
+    auto buffer = graph.CreateBuffer("Buffer", { 64 });
+
+    graph.AddPass("Compute", [&](RenderGraphBuilder& builder)
+    {
+        image = builder.Write(image, Access::ImageLoadStore);
+        buffer = builder.Write(buffer, Access::StorageBuffer);
+    }, {});
+    graph.AddPass("Draw", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(image, Access::TextureFetch);
+        builder.Read(buffer, Access::IndirectCommand);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+    graph.AddPass("DrawAgain", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(image, Access::TextureFetch);
+        builder.Read(backbuffer, Access::Framebuffer);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+
+    Check(graph.Compile(), "Compile");
+    Check(graph.GetBarrierBeforePass("Compute") == Access::None, "nothing to wait for before the first pass");
+    Check(graph.GetBarrierBeforePass("Draw") == (Access::TextureFetch | Access::IndirectCommand), "one barrier with both bits");
+    Check(graph.GetBarrierBeforePass("DrawAgain") == Access::None, "bits already issued are not repeated");
+    Check(graph.GetStats().UnbatchedBarriers == 2, "unbatched barriers");
+    Check(graph.GetStats().BatchedBarriers == 1, "batched barriers");
+}
+
+static void TestAliasedBarriers()
+{
+    RenderGraph graph;
+    auto backbuffer = graph.ImportTexture("Backbuffer", 0);
+    auto stored = graph.CreateTexture("Stored", { 16, 16, GLR32f, 1 });
+    auto blurred = graph.CreateTexture("Blurred", { 16, 16, GLRgba8, 1 });
+    auto drawn = graph.CreateTexture("Drawn", { 16, 16, GLR32f, 1 });
+
+    graph.AddPass("Compute", [&](RenderGraphBuilder& builder)
+    {
+        stored = builder.Write(stored, Access::ImageLoadStore);
+    }, {});
+    graph.AddPass("Blur", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(stored, Access::TextureFetch);
+        blurred = builder.Write(blurred, Access::Framebuffer);
+    }, {});
+    // lands in Stored's memory, which still has an image store nobody made visible to the framebuffer
+    graph.AddPass("Draw", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(blurred, Access::TextureFetch);
+        drawn = builder.Write(drawn, Access::Framebuffer);
+    }, {});
+    graph.AddPass("Present", [&](RenderGraphBuilder& builder)
+    {
+        builder.Read(drawn, Access::TextureFetch);
+        backbuffer = builder.Write(backbuffer, Access::Framebuffer);
+    }, {});
+
+    Check(graph.Compile(), "Compile");
+    Check(graph.GetPhysicalSlot(stored) == graph.GetPhysicalSlot(drawn), "Drawn aliases Stored");
+    Check(graph.GetBarrierBeforePass("Blur") == Access::TextureFetch, "image store made visible to the fetch");
+    Check(graph.GetBarrierBeforePass("Draw") == Access::Framebuffer, "aliased write waits for the image store");
+    Check(graph.GetBarrierBeforePass("Present") == Access::None, "framebuffer writes need no barrier");
+}
+
+int main()
+{
+    TestOrdering();
+    TestOutdatedWrite();
+    TestCulling();
+    TestAliasingAndPeakMemory();
+    TestBarriers();
+    TestAliasedBarriers();
+    return GetTestResult("RenderGraph");
+}
@@ -0,0 +1,124 @@
+#include <Project.Library/SoftwareOcclusionCulling.hpp>
+#include <Project.Library/ThreadPool.hpp>
+#include <Project.Tests/Check.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+struct CubeMesh
+{
+    std::vector<glm::vec3> Positions;
+    std::vector<uint32_t> Indices;
+};
+
+// Unit cube around the origin, counter clockwise when seen from outside
+static CubeMesh CreateCube()
+{
+    CubeMesh cube;
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        cube.Positions.emplace_back(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+    }
+    constexpr uint32_t faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+    for (const auto& face : faces)
+    {
+        cube.Indices.insert(cube.Indices.end(), { face[0], face[1], face[2], face[0], face[2], face[3] });
+    }
+    return cube;
+}
+
+static OccluderMesh CreateOccluder(const CubeMesh& cube, const glm::mat4& worldViewProjection)
+{
+    OccluderMesh occluder;
+    occluder.Positions = cube.Positions.data();
+    occluder.Indices = cube.Indices.data();
+    occluder.IndexCount = static_cast<uint32_t>(cube.Indices.size());
+    occluder.WorldViewProjection = worldViewProjection;
+    return occluder;
+}
+
+static glm::mat4 GetViewProjection(float aspectRatio)
+{
+    const auto projection = glm::perspective(glm::radians(80.0f), aspectRatio, 0.1f, 256.0f);
+    const auto view = glm::lookAt(glm::vec3(0.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return projection * view;
+}
+
+static bool IsBitIdentical(const std::vector<float>& lhs, const std::vector<float>& rhs)
+{
+    return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(float)) == 0;
+}
+
+// Random cubes, rotated and scaled, some of them crossing the near plane or leaving the guard band
+static void TestMatchesReference(uint32_t width, uint32_t height, uint32_t seed)
+{
+    const auto cube = CreateCube();
+    const auto viewProjection = GetViewProjection(static_cast<float>(width) / static_cast<float>(height));
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-16.0f, 16.0f);
+    std::uniform_real_distribution<float> scale(0.05f, 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+    std::vector<OccluderMesh> occluders;
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+        auto world = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random) - 4.0f));
+        world = glm::rotate(world, angle(random), glm::normalize(glm::vec3(position(random), position(random), 1.0f)));
+        world = glm::scale(world, glm::vec3(scale(random), scale(random), scale(random)));
+        occluders.push_back(CreateOccluder(cube, viewProjection * world));
+    }
+
+    ThreadPool threadPool;
+    SoftwareOcclusionCulling culling(width, height);
+    SoftwareOcclusionCulling reference(width, height);
+    // the second run starts from a dirty buffer and reused bins
+    culling.Rasterize(occluders, threadPool);
+    culling.Rasterize(occluders, threadPool);
+    reference.RasterizeReference(occluders);
+
+    Check(IsBitIdentical(culling.GetDepth(), reference.GetDepth()), "Rasterize matches RasterizeReference bit for bit");
+    Check(culling.GetStatistics().RasterizedTriangles == reference.GetStatistics().RasterizedTriangles, "same triangles survive setup");
+    Check(culling.GetStatistics().SubmittedTriangles == 2000 * 12, "submitted triangles");
+
+    uint32_t coveredPixels = 0;
+    for (const auto depth : culling.GetDepth())
+    {
+        coveredPixels += depth < 1.0f ? 1 : 0;
+    }
+    Check(coveredPixels > 0 && coveredPixels < culling.GetDepth().size(), "the scene covers part of the buffer");
+}
+
+static void TestOcclusion()
+{
+    const auto cube = CreateCube();
+    const auto viewProjection = GetViewProjection(2.0f);
+
+    ThreadPool threadPool;
+    SoftwareOcclusionCulling culling;
+    const std::vector<OccluderMesh> wall = { CreateOccluder(cube, viewProjection * glm::scale(glm::mat4(1.0f), glm::vec3(5.0f, 5.0f, 1.0f))) };
+    culling.Rasterize(wall, threadPool);
+
+    const auto boundsMin = glm::vec3(-0.5f);
+    const auto boundsMax = glm::vec3(0.5f);
+    const auto behind = viewProjection * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+    const auto inFront = viewProjection * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f));
+    const auto outside = viewProjection * glm::translate(glm::mat4(1.0f), glm::vec3(40.0f, 0.0f, -5.0f));
+    Check(culling.Test(behind, boundsMin, boundsMax) == OcclusionTestResult::Occluded, "bounds behind the wall are occluded");
+    Check(culling.Test(inFront, boundsMin, boundsMax) == OcclusionTestResult::Visible, "bounds in front of the wall are visible");
+    Check(culling.Test(outside, boundsMin, boundsMax) == OcclusionTestResult::OutsideFrustum, "bounds off screen are outside");
+    // the wall's own front face coincides with its depth and must not hide itself
+    Check(culling.Test(wall[0].WorldViewProjection, glm::vec3(-1.0f), glm::vec3(1.0f)) == OcclusionTestResult::Visible, "occluders do not hide themselves");
+}
+
+int main()
+{
+    spdlog::info("Test: AVX2 path {}", SoftwareOcclusionCulling::IsAvx2Enabled() ? "enabled" : "disabled");
+    TestMatchesReference(256, 128, 1);
+    TestMatchesReference(300, 100, 2);
+    TestMatchesReference(1024, 512, 3);
+    TestOcclusion();
+    return GetTestResult("SoftwareOcclusionCulling");
+}
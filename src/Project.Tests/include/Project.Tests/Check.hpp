@@ -0,0 +1,35 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <source_location>
+#include <string_view>
+
+// Failures are logged and counted, a test returns GetTestResult() from main so ctest sees them
+inline uint32_t& GetFailureCount()
+{
+    static uint32_t failureCount = 0;
+    return failureCount;
+}
+
+inline bool Check(bool condition, std::string_view what, std::source_location location = std::source_location::current())
+{
+    if (!condition)
+    {
+        spdlog::error("Test: {}:{} {} failed", location.file_name(), location.line(), what);
+        GetFailureCount()++;
+    }
+    return condition;
+}
+
+inline int GetTestResult(std::string_view testName)
+{
+    if (GetFailureCount() > 0)
+    {
+        spdlog::error("Test: {} had {} failures", testName, GetFailureCount());
+        return 1;
+    }
+    spdlog::info("Test: {} passed", testName);
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include <Project.TextureCompressor/BlockCompression.hpp>
+
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static uint16_t PackRgb565(const glm::vec3& color)
+{
+    const auto r = static_cast<uint16_t>(std::clamp(color.r * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    const auto g = static_cast<uint16_t>(std::clamp(color.g * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f));
+    const auto b = static_cast<uint16_t>(std::clamp(color.b * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// the same bit replication the hardware does
+static glm::vec3 UnpackRgb565(uint16_t color)
+{
+    const auto r = (color >> 11) & 31;
+    const auto g = (color >> 5) & 63;
+    const auto b = color & 31;
+    return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+void CompressBc1Block(const uint8_t* texels, uint8_t* block)
+{
+    std::array<glm::vec3, 16> colors;
+    auto mean = glm::vec3(0.0f);
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        colors[i] = glm::vec3(texels[i * 4 + 0], texels[i * 4 + 1], texels[i * 4 + 2]);
+        mean += colors[i];
+    }
+    mean /= 16.0f;
+
+    // endpoints at the extremes along the principal axis, found by power iteration on the covariance
+    float covariance[6] = {};
+    for (const auto& color : colors)
+    {
+        const auto d = color - mean;
+        covariance[0] += d.r * d.r;
+        covariance[1] += d.r * d.g;
+        covariance[2] += d.r * d.b;
+        covariance[3] += d.g * d.g;
+        covariance[4] += d.g * d.b;
+        covariance[5] += d.b * d.b;
+    }
+    // seeded with the covariance row of the channel that varies the most, a fixed grey seed is
+    // orthogonal to blocks like red against green and would flatten them to their mean
+    const std::array<glm::vec3, 3> rows =
+    {
+        glm::vec3(covariance[0], covariance[1], covariance[2]),
+        glm::vec3(covariance[1], covariance[3], covariance[4]),
+        glm::vec3(covariance[2], covariance[4], covariance[5])
+    };
+    auto axis = covariance[0] >= covariance[3] && covariance[0] >= covariance[5]
+        ? rows[0]
+        : covariance[3] >= covariance[5] ? rows[1] : rows[2];
+    for (uint32_t iteration = 0; iteration < 8; ++iteration)
+    {
+        axis = glm::vec3(
+            covariance[0] * axis.r + covariance[1] * axis.g + covariance[2] * axis.b,
+            covariance[1] * axis.r + covariance[3] * axis.g + covariance[4] * axis.b,
+            covariance[2] * axis.r + covariance[4] * axis.g + covariance[5] * axis.b);
+        const auto length = glm::length(axis);
+        if (length < 1e-6f)
+        {
+            axis = glm::vec3(0.0f);
+            break;
+        }
+        axis /= length;
+    }
+
+    auto minProjection = 0.0f;
+    auto maxProjection = 0.0f;
+    for (const auto& color : colors)
+    {
+        const auto projection = glm::dot(color - mean, axis);
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    auto color0 = PackRgb565(mean + axis * maxProjection);
+    auto color1 = PackRgb565(mean + axis * minProjection);
+    // color0 > color1 selects the four color mode, equal endpoints only ever use index 0
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        const auto endpoint0 = UnpackRgb565(color0);
+        const auto endpoint1 = UnpackRgb565(color1);
+        const std::array<glm::vec3, 4> palette =
+        {
+            endpoint0,
+            endpoint1,
+            (endpoint0 * 2.0f + endpoint1) / 3.0f,
+            (endpoint0 + endpoint1 * 2.0f) / 3.0f
+        };
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t bestIndex = 0;
+            auto bestDistance = std::numeric_limits<float>::max();
+            for (uint32_t index = 0; index < 4; ++index)
+            {
+                const auto d = colors[i] - palette[index];
+                const auto distance = glm::dot(d, d);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = index;
+                }
+            }
+            indices |= bestIndex << (i * 2);
+        }
+    }
+
+    std::memcpy(block + 0, &color0, sizeof(color0));
+    std::memcpy(block + 2, &color1, sizeof(color1));
+    std::memcpy(block + 4, &indices, sizeof(indices));
+}
+
+void CompressBc4Block(const uint8_t* texels, uint32_t channel, uint8_t* block)
+{
+    uint8_t minValue = 255;
+    uint8_t maxValue = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        minValue = std::min(minValue, texels[i * 4 + channel]);
+        maxValue = std::max(maxValue, texels[i * 4 + channel]);
+    }
+
+    // value0 > value1 selects the mode with six interpolated values between the endpoints
+    uint64_t indices = 0;
+    if (maxValue != minValue)
+    {
+        std::array<float, 8> palette = { float(maxValue), float(minValue) };
+        for (uint32_t step = 1; step < 7; ++step)
+        {
+            palette[step + 1] = (float(7 - step) * maxValue + float(step) * minValue) / 7.0f;
+        }
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const auto value = float(texels[i * 4 + channel]);
+            uint64_t bestIndex = 0;
+            auto bestDistance = std::numeric_limits<float>::max();
+            for (uint32_t index = 0; index < 8; ++index)
+            {
+                const auto distance = std::abs(value - palette[index]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = index;
+                }
+            }
+            indices |= bestIndex << (i * 3);
+        }
+    }
+
+    block[0] = maxValue;
+    block[1] = minValue;
+    for (uint32_t byte = 0; byte < 6; ++byte)
+    {
+        block[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+    }
+}
+
+void CompressBc3Block(const uint8_t* texels, uint8_t* block)
+{
+    CompressBc4Block(texels, 3, block);
+    CompressBc1Block(texels, block + 8);
+}
+
+void CompressBc5Block(const uint8_t* texels, uint8_t* block)
+{
+    CompressBc4Block(texels, 0, block);
+    CompressBc4Block(texels, 1, block + 8);
+}
+
+std::vector<uint8_t> CompressLevel(const Ktx2FormatInfo& formatInfo, const uint8_t* texels, uint32_t width, uint32_t height)
+{
+    void (*compressBlock)(const uint8_t*, uint8_t*) = nullptr;
+    switch (formatInfo.Format)
+    {
+        case Ktx2Format::R8G8B8A8Unorm:
+        case Ktx2Format::R8G8B8A8Srgb:
+            return std::vector<uint8_t>(texels, texels + static_cast<size_t>(width) * height * 4);
+        case Ktx2Format::Bc1RgbUnorm:
+        case Ktx2Format::Bc1RgbSrgb:
+            compressBlock = CompressBc1Block;
+            break;
+        case Ktx2Format::Bc3Unorm:
+        case Ktx2Format::Bc3Srgb:
+            compressBlock = CompressBc3Block;
+            break;
+        case Ktx2Format::Bc5Unorm:
+            compressBlock = CompressBc5Block;
+            break;
+        default:
+            return {};
+    }
+
+    const auto blocksX = (width + 3) / 4;
+    const auto blocksY = (height + 3) / 4;
+    std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * formatInfo.BlockBytes);
+    std::array<uint8_t, 64> blockTexels;
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+        {
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const auto sourceX = std::min(blockX * 4 + x, width - 1);
+                    const auto sourceY = std::min(blockY * 4 + y, height - 1);
+                    std::memcpy(blockTexels.data() + (y * 4 + x) * 4, texels + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+                }
+            }
+            compressBlock(blockTexels.data(), blocks.data() + (static_cast<size_t>(blockY) * blocksX + blockX) * formatInfo.BlockBytes);
+        }
+    }
+    return blocks;
+}
@@ -0,0 +1,200 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <Project.Library/Ktx2.hpp>
+#include <Project.TextureCompressor/BlockCompression.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <string_view>
+#include <vector>
+
+static float SrgbToLinear(float value)
+{
+    return value <= 0.04045f
+        ? value / 12.92f
+        : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSrgb(float value)
+{
+    return value <= 0.0031308f
+        ? value * 12.92f
+        : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// 2x2 box filter, averaged in linear space for sRGB images. Alpha is always linear
+static std::vector<uint8_t> DownsampleLevel(const std::vector<uint8_t>& texels, uint32_t width, uint32_t height, bool isSrgb)
+{
+    std::array<float, 256> toLinear;
+    for (uint32_t value = 0; value < 256; ++value)
+    {
+        toLinear[value] = isSrgb ? SrgbToLinear(value / 255.0f) : value / 255.0f;
+    }
+
+    const auto nextWidth = std::max(width / 2, 1u);
+    const auto nextHeight = std::max(height / 2, 1u);
+    std::vector<uint8_t> nextTexels(static_cast<size_t>(nextWidth) * nextHeight * 4);
+    for (uint32_t y = 0; y < nextHeight; ++y)
+    {
+        for (uint32_t x = 0; x < nextWidth; ++x)
+        {
+            std::array<float, 4> sum = {};
+            for (uint32_t sample = 0; sample < 4; ++sample)
+            {
+                const auto sourceX = std::min(x * 2 + (sample & 1), width - 1);
+                const auto sourceY = std::min(y * 2 + (sample >> 1), height - 1);
+                const auto* texel = texels.data() + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+                for (uint32_t channel = 0; channel < 3; ++channel)
+                {
+                    sum[channel] += toLinear[texel[channel]];
+                }
+                sum[3] += texel[3] / 255.0f;
+            }
+
+            auto* texel = nextTexels.data() + (static_cast<size_t>(y) * nextWidth + x) * 4;
+            for (uint32_t channel = 0; channel < 4; ++channel)
+            {
+                auto value = sum[channel] / 4.0f;
+                if (isSrgb && channel < 3)
+                {
+                    value = LinearToSrgb(value);
+                }
+                texel[channel] = static_cast<uint8_t>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    }
+    return nextTexels;
+}
+
+static bool HasAlpha(const std::vector<uint8_t>& texels)
+{
+    for (size_t i = 3; i < texels.size(); i += 4)
+    {
+        if (texels[i] != 255)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void PrintUsage()
+{
+    spdlog::info("Usage: Project.TextureCompressor [--format auto|bc1|bc3|bc5|rgba8] [--linear] <input> <output.ktx2>");
+    spdlog::info("  auto picks bc3 for images with alpha and bc1 otherwise, bc5 keeps red and green for normal maps");
+    spdlog::info("  --linear treats color as linear data, mips are filtered and stored without sRGB");
+}
+
+int main(int argc, char* argv[])
+{
+    std::string_view formatName = "auto";
+    auto isLinear = false;
+    std::vector<std::string_view> paths;
+    for (int32_t i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--format" && i + 1 < argc)
+        {
+            formatName = argv[++i];
+        }
+        else if (argument == "--linear")
+        {
+            isLinear = true;
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+    if (paths.size() != 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t channels = STBI_rgb_alpha;
+    auto* pixels = stbi_load(paths[0].data(), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        spdlog::error("TextureCompressor: Unable to load {}", paths[0]);
+        return 1;
+    }
+    std::vector<uint8_t> texels(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(pixels);
+
+    if (formatName == "auto")
+    {
+        formatName = HasAlpha(texels) ? "bc3" : "bc1";
+    }
+    Ktx2Format format;
+    if (formatName == "bc1")
+    {
+        format = isLinear ? Ktx2Format::Bc1RgbUnorm : Ktx2Format::Bc1RgbSrgb;
+    }
+    else if (formatName == "bc3")
+    {
+        format = isLinear ? Ktx2Format::Bc3Unorm : Ktx2Format::Bc3Srgb;
+    }
+    else if (formatName == "bc5")
+    {
+        // two channel data never is sRGB
+        format = Ktx2Format::Bc5Unorm;
+        isLinear = true;
+    }
+    else if (formatName == "rgba8")
+    {
+        format = isLinear ? Ktx2Format::R8G8B8A8Unorm : Ktx2Format::R8G8B8A8Srgb;
+    }
+    else
+    {
+        spdlog::error("TextureCompressor: Unknown format {}", formatName);
+        PrintUsage();
+        return 1;
+    }
+
+    Ktx2Image image;
+    image.FormatInfo = *GetKtx2FormatInfo(format);
+    image.Width = static_cast<uint32_t>(width);
+    image.Height = static_cast<uint32_t>(height);
+
+    const auto levelCount = static_cast<uint32_t>(std::bit_width(std::max(image.Width, image.Height)));
+    auto levelWidth = image.Width;
+    auto levelHeight = image.Height;
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        const auto levelData = CompressLevel(image.FormatInfo, texels.data(), levelWidth, levelHeight);
+        image.Levels.push_back({ levelWidth, levelHeight, image.Data.size(), levelData.size() });
+        image.Data.insert(image.Data.end(), levelData.begin(), levelData.end());
+
+        if (level + 1 < levelCount)
+        {
+            texels = DownsampleLevel(texels, levelWidth, levelHeight, !isLinear);
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+        }
+    }
+
+    if (!SaveKtx2(paths[1], image))
+    {
+        return 1;
+    }
+
+    const auto uncompressedSize = static_cast<size_t>(width) * height * 4 * 4 / 3;
+    spdlog::info("TextureCompressor: {} -> {}, {}x{} {} with {} levels, {} KiB instead of {} KiB",
+        paths[0],
+        paths[1],
+        width,
+        height,
+        formatName,
+        levelCount,
+        image.Data.size() / 1024,
+        uncompressedSize / 1024);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Project.Library/Ktx2.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// All blocks take 4x4 RGBA8 texels, row major
+
+// 8 bytes, opaque four color mode only
+void CompressBc1Block(const uint8_t* texels, uint8_t* block);
+// 8 bytes, one channel of the texels
+void CompressBc4Block(const uint8_t* texels, uint32_t channel, uint8_t* block);
+// 16 bytes, BC4 alpha followed by BC1 color
+void CompressBc3Block(const uint8_t* texels, uint8_t* block);
+// 16 bytes, BC4 red followed by BC4 green
+void CompressBc5Block(const uint8_t* texels, uint8_t* block);
+
+// One level of any size, texels past the right and bottom edge repeat the last ones.
+// Formats other than BC1, BC3, BC5 and RGBA8 give back an empty vector
+std::vector<uint8_t> CompressLevel(const Ktx2FormatInfo& formatInfo, const uint8_t* texels, uint32_t width, uint32_t height);
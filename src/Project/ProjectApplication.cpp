@@ -9,7 +9,10 @@
 #include <GLFW/glfw3.h>
 #include <imgui.h>
 
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <glm/mat4x4.hpp>
 
 #include <spdlog/spdlog.h>
@@ -17,12 +20,19 @@
 #include <unordered_map>
 #include <filesystem>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iterator>
 #include <fstream>
+#include <limits>
+#include <random>
 #include <vector>
 #include <queue>
 #include <set>
 
+constexpr float CameraNearPlane = 0.1f;
+constexpr float CameraFarPlane = 256.0f;
+
 static std::string Slurp(std::string_view path)
 {
     std::ifstream file(path.data(), std::ios::ate);
@@ -76,16 +86,55 @@ bool ProjectApplication::Load()
         return false;
     }
 
-    if (!MakeShader("./data/shaders/main.vs.glsl", "./data/shaders/main.fs.glsl"))
+    if (!MakeShader("./data/shaders/main.vs.glsl", "./data/shaders/main.fs.glsl", _shaderProgram))
     {
         return false;
     }
+    // batches bind their textures to units 0 to 15, so the samplers never change
+    for (int32_t unit = 0; unit < 16; ++unit)
+    {
+        glProgramUniform1i(_shaderProgram, 2 + unit, unit);
+    }
 
     LoadModel("./data/models/SM_Deccer_Cubes_Textured.gltf");
 
+    if (!CreateOcclusionCulling())
+    {
+        return false;
+    }
+    CreateClusteredLighting();
+
     return true;
 }
 
+void ProjectApplication::Unload()
+{
+    _textureStreamer.Release();
+
+    glDeleteBuffers(1, &_lightingBuffers.LightIndices);
+    glDeleteBuffers(1, &_lightingBuffers.Clusters);
+    glDeleteBuffers(1, &_lightingBuffers.Lights);
+
+    for (auto& fence : _occlusion.StatisticsFences)
+    {
+        if (fence != nullptr)
+        {
+            glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+    }
+    glDeleteQueries(_occlusion.SamplesPassedQueries.size(), _occlusion.SamplesPassedQueries.data());
+    glDeleteBuffers(_occlusion.StatisticsBuffers.size(), _occlusion.StatisticsBuffers.data());
+    glDeleteBuffers(1, &_occlusion.BoundsData);
+    glDeleteFramebuffers(1, &_occlusion.SceneFramebuffer);
+    glDeleteFramebuffers(1, &_occlusion.DepthPrepassFramebuffer);
+    glDeleteProgram(_occlusion.CullProgram);
+    glDeleteProgram(_occlusion.HiZProgram);
+    glDeleteProgram(_occlusion.DepthProgram);
+
+    Application::Unload();
+}
+
 void ProjectApplication::Update(float deltaTime)
 {
     if (IsKeyPressed(GLFW_KEY_ESCAPE))
@@ -94,51 +143,502 @@ void ProjectApplication::Update(float deltaTime)
     }
 
     _elapsedTime += deltaTime;
-}
 
-void ProjectApplication::RenderScene([[maybe_unused]] float deltaTime)
-{
-    const auto projection = glm::perspective(glm::radians(80.0f), 1920.0f / 1080.0f, 0.1f, 256.0f);
-    const auto view = glm::lookAt(
+    // without the pre-pass the scene draws straight into the backbuffer, at its full size
+    GetFramePacer().SetDynamicResolutionSupported(_isDepthPrepassEnabled);
+
+    int32_t width = 0;
+    int32_t height = 0;
+    GetFramebufferSize(width, height);
+    const auto aspectRatio = height > 0 ? static_cast<float>(width) / static_cast<float>(height) : 1.0f;
+    _projection = glm::perspective(glm::radians(80.0f), aspectRatio, CameraNearPlane, CameraFarPlane);
+    _view = glm::lookAt(
         glm::vec3(3 * std::cos(glfwGetTime() / 4), 2, -3 * std::sin(glfwGetTime() / 4)),
         glm::vec3(0, 0, 0),
         glm::vec3(0, 1, 0));
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glUseProgram(_shaderProgram);
-    glUniformMatrix4fv(0, 1, false, glm::value_ptr(projection));
-    glUniformMatrix4fv(1, 1, false, glm::value_ptr(view));
 
-    struct ObjectData
+    _occlusion.FrameIndex++;
+
+    // the scene renders at the dynamic resolution, finer levels than that would only eat upload budget
+    int32_t renderWidth = 0;
+    int32_t renderHeight = 0;
+    GetFramePacer().GetRenderSize(width, height, renderWidth, renderHeight);
+    RequestTextureLevels(renderWidth, renderHeight);
+
+    if (_isSoftwareOcclusionEnabled)
     {
-        uint32_t transformIndex;
-        uint32_t baseColorIndex;
-        uint32_t normalIndex;
-    };
-    struct BatchData
+        UpdateSoftwareOcclusion();
+    }
+
+    if (_isClusteredLightingEnabled)
     {
-        std::vector<ObjectData> objects;
-        std::vector<MeshIndirectInfo> indirectCommands;
+        UpdateClusteredLighting();
+    }
+}
+
+void ProjectApplication::UpdateSoftwareOcclusion()
+{
+    const auto viewProjection = _projection * _view;
+
+    // the meshes covering the most screen make the best occluders
+    struct OccluderCandidate
+    {
+        float Coverage;
+        uint32_t MeshIndex;
     };
-    std::vector<BatchData> objectBatches(_cubes.Commands.size());
-    std::vector<std::set<uint32_t>> textureHandles(_cubes.Commands.size());
+    std::vector<OccluderCandidate> candidates;
+    for (uint32_t meshIndex = 0; meshIndex < _cubes.Meshes.size(); ++meshIndex)
+    {
+        const auto& mesh = _cubes.Meshes[meshIndex];
+        const auto coverage = SoftwareOcclusionCulling::GetScreenCoverage(
+            viewProjection * _cubes.Transforms[mesh.TransformIndex],
+            glm::vec3(mesh.BoundsMin),
+            glm::vec3(mesh.BoundsMax));
+        if (coverage >= _occluderMinimumCoverage)
+        {
+            candidates.emplace_back(OccluderCandidate{ coverage, meshIndex });
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const OccluderCandidate& lhs, const OccluderCandidate& rhs)
+    {
+        return lhs.Coverage > rhs.Coverage;
+    });
+    candidates.resize(std::min(candidates.size(), static_cast<size_t>(std::max(_maxOccluders, 0))));
+
+    std::vector<OccluderMesh> occluders;
+    occluders.reserve(candidates.size());
+    for (const auto& candidate : candidates)
+    {
+        const auto& mesh = _cubes.Meshes[candidate.MeshIndex];
+        occluders.emplace_back(OccluderMesh
+        {
+            _cubes.Positions.data(),
+            _cubes.Indices.data() + mesh.indexOffset,
+            mesh.IndexCount,
+            mesh.VertexOffset,
+            viewProjection * _cubes.Transforms[mesh.TransformIndex]
+        });
+    }
+    _softwareOcclusion.Rasterize(occluders, _threadPool);
+
+    _softwareOcclusionStatistics = {};
+    _meshVisibility.resize(_cubes.Meshes.size());
+    for (uint32_t meshIndex = 0; meshIndex < _cubes.Meshes.size(); ++meshIndex)
+    {
+        const auto& mesh = _cubes.Meshes[meshIndex];
+        const auto result = _softwareOcclusion.Test(
+            viewProjection * _cubes.Transforms[mesh.TransformIndex],
+            glm::vec3(mesh.BoundsMin),
+            glm::vec3(mesh.BoundsMax));
+        _meshVisibility[meshIndex] = result == OcclusionTestResult::Visible;
+        _softwareOcclusionStatistics.TestedMeshes++;
+        _softwareOcclusionStatistics.FrustumRejectedMeshes += result == OcclusionTestResult::OutsideFrustum;
+        _softwareOcclusionStatistics.OcclusionRejectedMeshes += result == OcclusionTestResult::Occluded;
+    }
+}
+
+void ProjectApplication::RequestTextureLevels(int32_t width, int32_t height)
+{
+    // a mesh's screen footprint stands in for the texture's, every cube maps its texture once per face
+    const auto viewProjection = _projection * _view;
+    const auto pixelCount = static_cast<float>(width) * static_cast<float>(height);
     for (const auto& mesh : _cubes.Meshes)
     {
-        const auto index = mesh.BaseColorTexture / 16;
-        objectBatches[index].indirectCommands.emplace_back(MeshIndirectInfo
+        if (mesh.BaseColorTexture >= _cubes.Textures.size())
+        {
+            continue;
+        }
+
+        auto pixels = std::numeric_limits<float>::max();
+        if (_isTextureStreamingEnabled)
+        {
+            const auto coverage = SoftwareOcclusionCulling::GetScreenCoverage(
+                viewProjection * _cubes.Transforms[mesh.TransformIndex],
+                glm::vec3(mesh.BoundsMin),
+                glm::vec3(mesh.BoundsMax));
+            pixels = std::sqrt(coverage * pixelCount);
+        }
+        _textureStreamer.RequestScreenSize(_cubes.Textures[mesh.BaseColorTexture], pixels);
+    }
+}
+
+void ProjectApplication::StreamTextures()
+{
+    _textureStreamer.Update(static_cast<size_t>(std::max(_textureUploadBudgetKiB, 1)) * 1024);
+}
+
+void ProjectApplication::CreateClusteredLighting()
+{
+    glCreateBuffers(1, &_lightingBuffers.Lights);
+    glCreateBuffers(1, &_lightingBuffers.Clusters);
+    glCreateBuffers(1, &_lightingBuffers.LightIndices);
+}
+
+void ProjectApplication::GenerateLights(uint32_t lightCount, std::vector<LightData>& lights) const
+{
+    glm::vec3 sceneMin(std::numeric_limits<float>::max());
+    glm::vec3 sceneMax(std::numeric_limits<float>::lowest());
+    for (const auto& mesh : _cubes.Meshes)
+    {
+        for (uint32_t corner = 0; corner < 8; ++corner)
+        {
+            const auto position = glm::vec3(
+                corner & 1 ? mesh.BoundsMax.x : mesh.BoundsMin.x,
+                corner & 2 ? mesh.BoundsMax.y : mesh.BoundsMin.y,
+                corner & 4 ? mesh.BoundsMax.z : mesh.BoundsMin.z);
+            const auto world = glm::vec3(_cubes.Transforms[mesh.TransformIndex] * glm::vec4(position, 1.0f));
+            sceneMin = glm::min(sceneMin, world);
+            sceneMax = glm::max(sceneMax, world);
+        }
+    }
+    if (_cubes.Meshes.empty())
+    {
+        sceneMin = glm::vec3(-1.0f);
+        sceneMax = glm::vec3(1.0f);
+    }
+
+    // same seed every time, so a light count always produces the same lights
+    std::mt19937 random(lightCount);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto sceneSize = glm::length(sceneMax - sceneMin);
+    lights.resize(lightCount);
+    for (auto& light : lights)
+    {
+        light = {};
+        light.Position = glm::mix(sceneMin, sceneMax, glm::vec3(unit(random), unit(random), unit(random)));
+        light.Range = sceneSize * glm::mix(0.02f, 0.08f, unit(random));
+        light.Color = glm::vec3(unit(random), unit(random), unit(random));
+        light.Intensity = light.Range * light.Range * 0.5f;
+        // every fourth light is a spot light
+        if (random() % 4 == 0)
+        {
+            light.Direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) * 2.0f - 1.0f);
+            light.SpotOuterCos = glm::mix(0.5f, 0.9f, unit(random));
+            light.SpotInnerCos = glm::mix(light.SpotOuterCos, 1.0f, 0.5f);
+        }
+    }
+}
+
+void ProjectApplication::UpdateClusteredLighting()
+{
+    if (_lights.size() != static_cast<size_t>(_lightCount))
+    {
+        GenerateLights(static_cast<uint32_t>(_lightCount), _lights);
+        _lightingBuffers.AreLightsDirty = true;
+    }
+
+    _clusteredLighting.SetProjection(_projection, CameraNearPlane, CameraFarPlane);
+    _clusteredLighting.Assign(_lights, _view, _threadPool);
+}
+
+void ProjectApplication::UploadClusteredLighting(int32_t width, int32_t height)
+{
+    glUniform1i(21, _isClusteredLightingEnabled);
+    if (!_isClusteredLightingEnabled)
+    {
+        return;
+    }
+
+    // zero sized buffers can not be bound, keep at least one element around
+    if (_lightingBuffers.AreLightsDirty)
+    {
+        glNamedBufferData(
+            _lightingBuffers.Lights,
+            std::max<size_t>(_lights.size(), 1) * sizeof(LightData),
+            _lights.empty() ? nullptr : _lights.data(),
+            GL_STATIC_DRAW);
+        _lightingBuffers.AreLightsDirty = false;
+    }
+    const auto& clusters = _clusteredLighting.GetClusters();
+    const auto& lightIndices = _clusteredLighting.GetLightIndices();
+    glNamedBufferData(
+        _lightingBuffers.Clusters,
+        clusters.size() * sizeof(ClusterLightRange),
+        clusters.data(),
+        GL_STREAM_DRAW);
+    glNamedBufferData(
+        _lightingBuffers.LightIndices,
+        std::max<size_t>(lightIndices.size(), 1) * sizeof(uint32_t),
+        lightIndices.empty() ? nullptr : lightIndices.data(),
+        GL_STREAM_DRAW);
+
+    auto& stateCache = GetStateCache();
+    stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _lightingBuffers.Lights);
+    stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _lightingBuffers.Clusters);
+    stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, _lightingBuffers.LightIndices);
+    glUniform3ui(18, _clusteredLighting.GetTilesX(), _clusteredLighting.GetTilesY(), _clusteredLighting.GetSlices());
+    glUniform2f(19,
+        static_cast<float>(width) / static_cast<float>(_clusteredLighting.GetTilesX()),
+        static_cast<float>(height) / static_cast<float>(_clusteredLighting.GetTilesY()));
+    glUniform2f(20, _clusteredLighting.GetSliceScale(), _clusteredLighting.GetSliceBias());
+}
+
+void ProjectApplication::RenderScene([[maybe_unused]] float deltaTime)
+{
+    StreamTextures();
+
+    int32_t width = 0;
+    int32_t height = 0;
+    GetFramebufferSize(width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    GetStateCache().UseProgram(_shaderProgram);
+    glUniformMatrix4fv(0, 1, false, glm::value_ptr(_projection));
+    glUniformMatrix4fv(1, 1, false, glm::value_ptr(_view));
+    UploadClusteredLighting(width, height);
+
+    UploadBatches();
+    BeginOverdrawQuery(static_cast<uint64_t>(width) * height);
+    DrawBatches(true);
+    EndOverdrawQuery();
+}
+
+RenderGraphResource ProjectApplication::BuildRenderGraph(RenderGraph& renderGraph, RenderGraphResource backbuffer, float deltaTime)
+{
+    int32_t width = 0;
+    int32_t height = 0;
+    GetFramebufferSize(width, height);
+    if (!_isDepthPrepassEnabled || width <= 0 || height <= 0)
+    {
+        return Application::BuildRenderGraph(renderGraph, backbuffer, deltaTime);
+    }
+
+    // the scene renders at the dynamic resolution, Present scales it up to the backbuffer
+    int32_t sceneWidth = 0;
+    int32_t sceneHeight = 0;
+    GetFramePacer().GetRenderSize(width, height, sceneWidth, sceneHeight);
+    const auto renderWidth = static_cast<uint32_t>(sceneWidth);
+    const auto renderHeight = static_cast<uint32_t>(sceneHeight);
+    const auto hiZLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(renderWidth, renderHeight)))) + 1;
+    auto sceneColor = renderGraph.CreateTexture("SceneColor", { renderWidth, renderHeight, GL_RGBA8, 1 });
+    auto sceneDepth = renderGraph.CreateTexture("SceneDepth", { renderWidth, renderHeight, GL_DEPTH_COMPONENT32F, 1 });
+    auto hiZ = renderGraph.CreateTexture("HiZ", { renderWidth, renderHeight, GL_R32F, hiZLevels });
+    // stands in for all per batch command buffers, they are owned by _cubes
+    auto drawCommands = renderGraph.ImportBuffer("DrawCommands", 0);
+    // stands in for every texture the streamer owns
+    auto streamedTextures = renderGraph.ImportTexture("StreamedTextures", 0);
+
+    renderGraph.AddPass("TextureStreaming",
+        [&](RenderGraphBuilder& builder)
+        {
+            streamedTextures = builder.Write(streamedTextures, RenderGraphAccess::TextureUpdate);
+        },
+        [this](RenderGraphContext&)
+        {
+            StreamTextures();
+        });
+
+    // Draws what the cull pass let through last frame, those commands are still
+    // sitting in _cubes.Commands and are not tracked by this frame's graph
+    renderGraph.AddPass("DepthPrepass",
+        [&](RenderGraphBuilder& builder)
+        {
+            sceneDepth = builder.Write(sceneDepth, RenderGraphAccess::Framebuffer);
+        },
+        [this, sceneDepth, sceneWidth, sceneHeight](RenderGraphContext& context)
+        {
+            // attached every frame, the pool may have deleted last frame's texture and handed its name out again
+            const auto depth = context.GetTexture(sceneDepth);
+            glNamedFramebufferTexture(_occlusion.DepthPrepassFramebuffer, GL_DEPTH_ATTACHMENT, depth, 0);
+            glNamedFramebufferTexture(_occlusion.SceneFramebuffer, GL_DEPTH_ATTACHMENT, depth, 0);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, _occlusion.DepthPrepassFramebuffer);
+            glViewport(0, 0, sceneWidth, sceneHeight);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            if (!_hasUploadedBatches)
+            {
+                return;
+            }
+
+            GetStateCache().UseProgram(_occlusion.DepthProgram);
+            glUniformMatrix4fv(0, 1, false, glm::value_ptr(_projection));
+            glUniformMatrix4fv(1, 1, false, glm::value_ptr(_view));
+            DrawBatches(false);
+        });
+
+    renderGraph.AddPass("HiZ",
+        [&](RenderGraphBuilder& builder)
+        {
+            builder.Read(sceneDepth, RenderGraphAccess::TextureFetch);
+            hiZ = builder.Write(hiZ, RenderGraphAccess::ImageLoadStore);
+        },
+        [this, sceneDepth, hiZ](RenderGraphContext& context)
+        {
+            const auto& desc = context.GetTextureDesc(hiZ);
+            const auto hiZTexture = context.GetTexture(hiZ);
+            auto& stateCache = GetStateCache();
+            stateCache.UseProgram(_occlusion.HiZProgram);
+            stateCache.BindTextureUnit(0, context.GetTexture(sceneDepth));
+            for (uint32_t level = 0; level < desc.Levels; ++level)
+            {
+                if (level > 0)
+                {
+                    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+                    glBindImageTexture(0, hiZTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+                }
+                glBindImageTexture(1, hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+                glUniform1i(0, level);
+                const auto levelWidth = std::max(desc.Width >> level, 1u);
+                const auto levelHeight = std::max(desc.Height >> level, 1u);
+                glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+            }
+        });
+
+    renderGraph.AddPass("OcclusionCull",
+        [&](RenderGraphBuilder& builder)
+        {
+            builder.Read(hiZ, RenderGraphAccess::TextureFetch);
+            drawCommands = builder.Write(drawCommands, RenderGraphAccess::StorageBuffer);
+        },
+        [this, hiZ](RenderGraphContext& context)
+        {
+            ReadOcclusionStatistics();
+            UploadBatches();
+
+            const auto slot = _occlusion.FrameIndex % OcclusionCulling::FramesInFlight;
+            const auto statisticsBuffer = _occlusion.StatisticsBuffers[slot];
+            glClearNamedBufferData(statisticsBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+            auto& stateCache = GetStateCache();
+            stateCache.UseProgram(_occlusion.CullProgram);
+            glUniformMatrix4fv(0, 1, false, glm::value_ptr(_projection));
+            glUniformMatrix4fv(1, 1, false, glm::value_ptr(_view));
+            stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _cubes.TransformData);
+            stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _occlusion.BoundsData);
+            stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, statisticsBuffer);
+            stateCache.BindTextureUnit(0, context.GetTexture(hiZ));
+            for (uint32_t index = 0; const auto& batch : _batches)
+            {
+                const auto drawCount = static_cast<uint32_t>(batch.IndirectCommands.size());
+                if (drawCount > 0)
+                {
+                    stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _cubes.ObjectData[index]);
+                    stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _cubes.Commands[index]);
+                    glUniform1ui(2, drawCount);
+                    glDispatchCompute((drawCount + 63) / 64, 1, 1);
+                }
+                index++;
+            }
+
+            _occlusion.StatisticsFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        });
+
+    renderGraph.AddPass("Scene",
+        [&](RenderGraphBuilder& builder)
+        {
+            builder.Read(drawCommands, RenderGraphAccess::IndirectCommand);
+            builder.Read(streamedTextures, RenderGraphAccess::TextureFetch);
+            builder.Read(sceneDepth, RenderGraphAccess::Framebuffer);
+            sceneDepth = builder.Write(sceneDepth, RenderGraphAccess::Framebuffer);
+            sceneColor = builder.Write(sceneColor, RenderGraphAccess::Framebuffer);
+        },
+        [this, sceneColor, sceneWidth, sceneHeight](RenderGraphContext& context)
+        {
+            glNamedFramebufferTexture(_occlusion.SceneFramebuffer, GL_COLOR_ATTACHMENT0, context.GetTexture(sceneColor), 0);
+
+            // meshes which were hidden last frame are not in the pre-pass depth yet, so keep writing depth
+            glBindFramebuffer(GL_FRAMEBUFFER, _occlusion.SceneFramebuffer);
+            glViewport(0, 0, sceneWidth, sceneHeight);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDepthFunc(GL_LEQUAL);
+            GetStateCache().UseProgram(_shaderProgram);
+            glUniformMatrix4fv(0, 1, false, glm::value_ptr(_projection));
+            glUniformMatrix4fv(1, 1, false, glm::value_ptr(_view));
+            UploadClusteredLighting(sceneWidth, sceneHeight);
+            BeginOverdrawQuery(static_cast<uint64_t>(sceneWidth) * sceneHeight);
+            DrawBatches(true);
+            EndOverdrawQuery();
+            glDepthFunc(GL_LESS);
+        });
+
+    renderGraph.AddPass("Present",
+        [&](RenderGraphBuilder& builder)
+        {
+            builder.Read(sceneColor, RenderGraphAccess::Framebuffer);
+            backbuffer = builder.Write(backbuffer, RenderGraphAccess::Framebuffer);
+        },
+        [this, width, height, sceneWidth, sceneHeight](RenderGraphContext&)
+        {
+            const auto isScaled = sceneWidth != width || sceneHeight != height;
+            glBlitNamedFramebuffer(
+                _occlusion.SceneFramebuffer,
+                0,
+                0, 0, sceneWidth, sceneHeight,
+                0, 0, width, height,
+                GL_COLOR_BUFFER_BIT,
+                isScaled ? GL_LINEAR : GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        });
+
+    return backbuffer;
+}
+
+void ProjectApplication::UploadBatches()
+{
+    if (_batches.empty())
+    {
+        _batches.resize(_cubes.Commands.size());
+        std::vector<std::set<uint32_t>> textureHandles(_cubes.Commands.size());
+        for (const auto& mesh : _cubes.Meshes)
+        {
+            textureHandles[mesh.BaseColorTexture / 16].insert(_cubes.Textures[mesh.BaseColorTexture]);
+        }
+        for (uint32_t index = 0; index < _batches.size(); ++index)
+        {
+            _batches[index].Textures.assign(textureHandles[index].begin(), textureHandles[index].end());
+        }
+    }
+
+    // One program and one pass for now, so the texture set decides the batch
+    // and the depth bucket orders the draws front to back inside of it
+    constexpr uint32_t opaquePass = 0;
+    constexpr uint32_t mainProgram = 0;
+    _drawQueue.Clear();
+    for (uint32_t meshIndex = 0; meshIndex < _cubes.Meshes.size(); ++meshIndex)
+    {
+        const auto& mesh = _cubes.Meshes[meshIndex];
+        const auto center = glm::vec3(mesh.BoundsMin + mesh.BoundsMax) * 0.5f;
+        const auto viewDepth = -(_view * _cubes.Transforms[mesh.TransformIndex] * glm::vec4(center, 1.0f)).z;
+        const auto depth = (viewDepth - CameraNearPlane) / (CameraFarPlane - CameraNearPlane);
+        _drawQueue.Add(
+            DrawSortKey::Make(opaquePass, mainProgram, mesh.BaseColorTexture / 16, DrawSortKey::QuantizeDepth(depth)),
+            meshIndex);
+    }
+    if (_isDrawSortingEnabled)
+    {
+        _drawQueue.Sort(_threadPool);
+    }
+
+    for (auto& batch : _batches)
+    {
+        batch.Objects.clear();
+        batch.IndirectCommands.clear();
+        batch.MeshIndices.clear();
+    }
+    const auto useSoftwareOcclusion = _isSoftwareOcclusionEnabled && _meshVisibility.size() == _cubes.Meshes.size();
+    const auto keys = _drawQueue.GetKeys();
+    const auto meshIndices = _drawQueue.GetItems();
+    for (uint32_t draw = 0; draw < _drawQueue.GetSize(); ++draw)
+    {
+        const auto meshIndex = meshIndices[draw];
+        const auto& mesh = _cubes.Meshes[meshIndex];
+        auto& batch = _batches[DrawSortKey::GetMaterial(keys[draw])];
+        batch.IndirectCommands.emplace_back(MeshIndirectInfo
         {
             mesh.IndexCount,
-            1,
+            !useSoftwareOcclusion || _meshVisibility[meshIndex] ? 1u : 0u,
             mesh.indexOffset,
             mesh.VertexOffset,
             1
         });
-        objectBatches[index].objects.emplace_back(ObjectData
+        batch.Objects.emplace_back(ObjectData
         {
             mesh.TransformIndex,
             mesh.BaseColorTexture % 16,
             mesh.NormalTexture
         });
-        textureHandles[index].insert(_cubes.Textures[mesh.BaseColorTexture]);
+        batch.MeshIndices.emplace_back(meshIndex);
     }
 
     glNamedBufferData(
@@ -146,42 +646,106 @@ void ProjectApplication::RenderScene([[maybe_unused]] float deltaTime)
         _cubes.Transforms.size() * sizeof(glm::mat4),
         _cubes.Transforms.data(),
         GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _cubes.TransformData);
 
-    for (uint32_t index = 0; const auto& batch : objectBatches)
+    for (uint32_t index = 0; const auto& batch : _batches)
     {
         glNamedBufferData(
             _cubes.ObjectData[index],
-            batch.objects.size() * sizeof(ObjectData),
-            batch.objects.data(),
+            batch.Objects.size() * sizeof(ObjectData),
+            batch.Objects.data(),
             GL_DYNAMIC_DRAW);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _cubes.ObjectData[index]);
-
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _cubes.Commands[index]);
         glNamedBufferData(
             _cubes.Commands[index],
-            batch.indirectCommands.size() * sizeof(MeshIndirectInfo),
-            batch.indirectCommands.data(),
+            batch.IndirectCommands.size() * sizeof(MeshIndirectInfo),
+            batch.IndirectCommands.data(),
             GL_DYNAMIC_DRAW);
+        index++;
+    }
 
-        for (uint32_t offset = 0; const auto texture : textureHandles[index])
+    _hasUploadedBatches = true;
+}
+
+void ProjectApplication::DrawBatches(bool bindTextures)
+{
+    auto& stateCache = GetStateCache();
+    stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _cubes.TransformData);
+    stateCache.BindVertexArray(_cubes.InputLayout);
+    for (uint32_t index = 0; const auto& batch : _batches)
+    {
+        if (batch.IndirectCommands.empty())
         {
-            glUniform1i(2 + offset, offset);
-            glActiveTexture(GL_TEXTURE0 + offset);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            offset++;
+            index++;
+            continue;
+        }
+
+        stateCache.BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _cubes.ObjectData[index]);
+        stateCache.BindBuffer(GL_DRAW_INDIRECT_BUFFER, _cubes.Commands[index]);
+        if (bindTextures)
+        {
+            for (uint32_t unit = 0; const auto texture : batch.Textures)
+            {
+                stateCache.BindTextureUnit(unit++, texture);
+            }
         }
-        glBindVertexArray(_cubes.InputLayout);
         glMultiDrawElementsIndirect(
             GL_TRIANGLES,
             GL_UNSIGNED_INT,
             nullptr,
-            batch.indirectCommands.size(),
+            batch.IndirectCommands.size(),
             sizeof(MeshIndirectInfo));
         index++;
     }
 }
 
+void ProjectApplication::BeginOverdrawQuery(uint64_t pixelCount)
+{
+    const auto slot = _occlusion.FrameIndex % OcclusionCulling::FramesInFlight;
+    const auto query = _occlusion.SamplesPassedQueries[slot];
+    if (_occlusion.IsQueryPending[slot])
+    {
+        uint32_t isAvailable = GL_FALSE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (isAvailable == GL_TRUE && _occlusion.QueryPixelCounts[slot] > 0)
+        {
+            uint64_t samplesPassed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samplesPassed);
+            _occlusionStatistics.Overdraw = static_cast<float>(samplesPassed) / static_cast<float>(_occlusion.QueryPixelCounts[slot]);
+        }
+    }
+
+    _occlusion.QueryPixelCounts[slot] = pixelCount;
+    glBeginQuery(GL_SAMPLES_PASSED, query);
+}
+
+void ProjectApplication::EndOverdrawQuery()
+{
+    glEndQuery(GL_SAMPLES_PASSED);
+    _occlusion.IsQueryPending[_occlusion.FrameIndex % OcclusionCulling::FramesInFlight] = true;
+}
+
+void ProjectApplication::ReadOcclusionStatistics()
+{
+    // only look at results the GPU is done with, never wait for them
+    const auto slot = _occlusion.FrameIndex % OcclusionCulling::FramesInFlight;
+    auto& fence = _occlusion.StatisticsFences[slot];
+    if (fence == nullptr)
+    {
+        return;
+    }
+
+    const auto waitResult = glClientWaitSync(static_cast<GLsync>(fence), 0, 0);
+    if (waitResult == GL_ALREADY_SIGNALED || waitResult == GL_CONDITION_SATISFIED)
+    {
+        uint32_t statistics[3] = {};
+        glGetNamedBufferSubData(_occlusion.StatisticsBuffers[slot], 0, sizeof(statistics), statistics);
+        _occlusionStatistics.TestedMeshes = statistics[0];
+        _occlusionStatistics.FrustumRejectedMeshes = statistics[1];
+        _occlusionStatistics.OcclusionRejectedMeshes = statistics[2];
+    }
+    glDeleteSync(static_cast<GLsync>(fence));
+    fence = nullptr;
+}
+
 void ProjectApplication::RenderUI(float deltaTime)
 {
     ImGui::Begin("Window");
@@ -192,54 +756,297 @@ void ProjectApplication::RenderUI(float deltaTime)
         ImGui::End();
     }
 
+    ImGui::Begin("Occlusion Culling");
+    {
+        ImGui::Checkbox("Depth pre-pass and Hi-Z culling", &_isDepthPrepassEnabled);
+        ImGui::Text("Overdraw: %.2f fragments per pixel", _occlusionStatistics.Overdraw);
+        if (_isDepthPrepassEnabled)
+        {
+            ImGui::Text("Meshes tested: %u", _occlusionStatistics.TestedMeshes);
+            ImGui::Text("Rejected by frustum: %u", _occlusionStatistics.FrustumRejectedMeshes);
+            ImGui::Text("Rejected by occlusion: %u", _occlusionStatistics.OcclusionRejectedMeshes);
+        }
+        ImGui::End();
+    }
+
+    ImGui::Begin("Software Occlusion Culling");
+    {
+        ImGui::Checkbox("Cull against a CPU rasterized depth buffer", &_isSoftwareOcclusionEnabled);
+        ImGui::SliderFloat("Minimum occluder coverage", &_occluderMinimumCoverage, 0.0f, 0.25f);
+        ImGui::SliderInt("Maximum occluders", &_maxOccluders, 0, 256);
+        if (_isSoftwareOcclusionEnabled)
+        {
+            const auto& statistics = _softwareOcclusion.GetStatistics();
+            ImGui::Text("Depth buffer: %ux%u on %u threads", _softwareOcclusion.GetWidth(), _softwareOcclusion.GetHeight(), _threadPool.GetThreadCount());
+            ImGui::Text("Occluders: %u, %u of %u triangles rasterized", statistics.Occluders, statistics.RasterizedTriangles, statistics.SubmittedTriangles);
+            ImGui::Text("Rasterization: %.3f ms, %.0f triangles/ms", statistics.RasterizationMilliseconds, statistics.TrianglesPerMillisecond);
+            ImGui::Text("Meshes tested: %u", _softwareOcclusionStatistics.TestedMeshes);
+            ImGui::Text("Rejected by frustum: %u", _softwareOcclusionStatistics.FrustumRejectedMeshes);
+            ImGui::Text("Rejected by occlusion: %u", _softwareOcclusionStatistics.OcclusionRejectedMeshes);
+        }
+        ImGui::End();
+    }
+
+    ImGui::Begin("Draw Submission");
+    {
+        ImGui::Checkbox("Sort draws by key", &_isDrawSortingEnabled);
+        ImGui::Text("Draws: %u, sorted in %.3f ms", _drawQueue.GetSize(), _isDrawSortingEnabled ? _drawQueue.GetSortMilliseconds() : 0.0f);
+
+        constexpr const char* stateNames[] = { "Programs", "Vertex arrays", "Textures", "Indexed buffers", "Buffers" };
+        const auto& statistics = GetStateCache().GetStatistics();
+        uint32_t issued = 0;
+        uint32_t skipped = 0;
+        for (size_t type = 0; type < static_cast<size_t>(GLStateType::Count); ++type)
+        {
+            ImGui::Text("%s: %u bound, %u redundant skipped", stateNames[type], statistics.Issued[type], statistics.Skipped[type]);
+            issued += statistics.Issued[type];
+            skipped += statistics.Skipped[type];
+        }
+        ImGui::Text("State changes this frame: %u issued, %u avoided", issued, skipped);
+
+        ImGui::End();
+    }
+
+    ImGui::Begin("Clustered Lighting");
+    {
+        ImGui::Checkbox("Clustered forward lighting", &_isClusteredLightingEnabled);
+        ImGui::SliderInt("Lights", &_lightCount, 0, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+        if (_isClusteredLightingEnabled)
+        {
+            const auto& statistics = _clusteredLighting.GetStatistics();
+            ImGui::Text("Grid: %ux%ux%u clusters", _clusteredLighting.GetTilesX(), _clusteredLighting.GetTilesY(), _clusteredLighting.GetSlices());
+            ImGui::Text("Assignment: %.3f ms on %u threads", statistics.AssignmentMilliseconds, _threadPool.GetThreadCount());
+            ImGui::Text("Light indices: %u, %u clusters occupied, at most %u lights in one",
+                statistics.LightIndices,
+                statistics.OccupiedClusters,
+                statistics.MaxLightsPerCluster);
+        }
+        ImGui::End();
+    }
+
+    ImGui::Begin("Texture Streaming");
+    {
+        constexpr auto toMegabytes = 1.0f / (1024.0f * 1024.0f);
+        const auto& statistics = _textureStreamer.GetStatistics();
+        ImGui::Checkbox("Stream by screen size", &_isTextureStreamingEnabled);
+        ImGui::SliderInt("Upload budget (KiB)", &_textureUploadBudgetKiB, 64, 65536, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::Text("Textures: %u, %u block compressed, %u streaming", statistics.Textures, statistics.CompressedTextures, statistics.StreamingTextures);
+        ImGui::Text("VRAM: %.2f MB allocated, %.2f MB resident", statistics.AllocatedBytes * toMegabytes, statistics.ResidentBytes * toMegabytes);
+        ImGui::Text("As RGBA8 with full mips: %.2f MB", statistics.UncompressedBytes * toMegabytes);
+        if (statistics.UncompressedBytes > 0)
+        {
+            ImGui::Text("Saved: %.1f%%", 100.0f - 100.0f * statistics.AllocatedBytes / statistics.UncompressedBytes);
+        }
+        ImGui::Text("Uploads: %.2f MB pending, %.2f MB this frame", statistics.PendingBytes * toMegabytes, statistics.UploadedBytes * toMegabytes);
+        ImGui::End();
+    }
+
+    ImGui::Begin("Frame Pacing");
+    {
+        auto& framePacer = GetFramePacer();
+        auto& settings = framePacer.GetSettings();
+        const auto& statistics = framePacer.GetStatistics();
+
+        constexpr const char* vsyncNames[] = { "Off", "On", "Adaptive", "Half rate" };
+        constexpr VsyncMode vsyncModes[] = { VsyncMode::Off, VsyncMode::On, VsyncMode::Adaptive, VsyncMode::Half };
+        auto vsyncIndex = static_cast<int32_t>(std::distance(std::begin(vsyncModes), std::find(std::begin(vsyncModes), std::end(vsyncModes), settings.Vsync)));
+        if (ImGui::Combo("Vsync", &vsyncIndex, vsyncNames, IM_ARRAYSIZE(vsyncNames)))
+        {
+            settings.Vsync = vsyncModes[vsyncIndex];
+        }
+        if (settings.Vsync == VsyncMode::Adaptive && !statistics.IsAdaptiveVsyncSupported)
+        {
+            ImGui::TextUnformatted("Adaptive vsync is not supported, using regular vsync");
+        }
+
+        auto maxFramesInFlight = static_cast<int32_t>(settings.MaxFramesInFlight);
+        if (ImGui::SliderInt("Max frames in flight", &maxFramesInFlight, 1, static_cast<int32_t>(FramePacer::MaxQueuedFrames)))
+        {
+            settings.MaxFramesInFlight = static_cast<uint32_t>(maxFramesInFlight);
+        }
+        ImGui::Checkbox("Just in time input", &settings.IsJustInTimeEnabled);
+        ImGui::SliderFloat("Safety margin (ms)", &settings.JustInTimeMarginMilliseconds, 0.0f, 8.0f);
+        ImGui::SliderFloat("Target frame time (ms)", &settings.TargetFrameMilliseconds, 4.0f, 50.0f);
+        ImGui::BeginDisabled(!_isDepthPrepassEnabled);
+        ImGui::Checkbox("Dynamic resolution", &settings.IsDynamicResolutionEnabled);
+        ImGui::SliderFloat("Minimum scale", &settings.MinRenderScale, 0.25f, 1.0f);
+        ImGui::EndDisabled();
+        if (!_isDepthPrepassEnabled)
+        {
+            ImGui::TextUnformatted("Dynamic resolution needs the depth pre-pass");
+        }
+
+        const auto& frame = statistics.LastFrame;
+        ImGui::Text("Refresh: %.2f ms, %u frames in flight", statistics.RefreshMilliseconds, statistics.FramesInFlight);
+        ImGui::Text("Frame %.2f ms: CPU %.2f ms, GPU %.2f ms, predicted cost %.2f ms",
+            frame.FrameMilliseconds,
+            frame.CpuMilliseconds,
+            frame.GpuMilliseconds,
+            statistics.PredictedCostMilliseconds);
+        ImGui::Text("Waits: %.2f ms on fences, %.2f ms just in time", frame.FenceWaitMilliseconds, frame.JustInTimeWaitMilliseconds);
+        ImGui::Text("Render scale: %.0f%%", frame.RenderScale * 100.0f);
+
+        const auto plotHistogram = [](const char* label, const FrameHistogram& histogram)
+        {
+            const auto& bins = histogram.GetBins();
+            char overlay[64];
+            std::snprintf(overlay, sizeof(overlay), "p50 %.1f ms, p95 %.1f ms, p99 %.1f ms",
+                histogram.GetPercentile(50.0f),
+                histogram.GetPercentile(95.0f),
+                histogram.GetPercentile(99.0f));
+            ImGui::PlotHistogram(label, bins.data(), static_cast<int32_t>(bins.size()), 0, overlay, 0.0f, FLT_MAX, ImVec2(0, 80));
+        };
+        plotHistogram("Frame time", framePacer.GetFrameTimeHistogram());
+        plotHistogram("Input to GPU done", framePacer.GetLatencyHistogram());
+        const auto& latencyHistogram = framePacer.GetLatencyHistogram();
+        ImGui::Text("%u frames, %.1f ms bins, the last one takes everything above %.0f ms",
+            latencyHistogram.GetSampleCount(),
+            latencyHistogram.GetBinMilliseconds(),
+            latencyHistogram.GetBinMilliseconds() * static_cast<float>(latencyHistogram.GetBins().size() - 1));
+
+        if (ImGui::Button("Reset"))
+        {
+            framePacer.ResetHistograms();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export CSV"))
+        {
+            framePacer.ExportCsv("./frame_pacing.csv");
+        }
+        ImGui::End();
+    }
+
+    ImGui::Begin("Render Graph");
+    {
+        const auto& stats = GetRenderGraph().GetStats();
+        for (const auto passName : GetRenderGraph().GetPassOrder())
+        {
+            ImGui::BulletText("%.*s", static_cast<int>(passName.size()), passName.data());
+        }
+        ImGui::Text("Passes: %u declared, %u culled", stats.DeclaredPasses, stats.CulledPasses);
+        ImGui::Text("Transient resources: %u on %u allocations", stats.TransientResources, stats.PhysicalResources);
+        ImGui::Text("Transient memory: %.2f MB aliased, %.2f MB without aliasing, %.2f MB peak live",
+            stats.TransientMemoryWithAliasing / (1024.0f * 1024.0f),
+            stats.TransientMemoryWithoutAliasing / (1024.0f * 1024.0f),
+            stats.PeakLiveTransientMemory / (1024.0f * 1024.0f));
+        ImGui::Text("Memory barriers: %u issued for %u dependencies", stats.BatchedBarriers, stats.UnbatchedBarriers);
+        ImGui::End();
+    }
+
     ImGui::ShowDemoWindow();
 }
 
-bool ProjectApplication::MakeShader(std::string_view vertexShaderFilePath, std::string_view fragmentShaderFilePath)
+static bool CompileShader(GLenum type, std::string_view filePath, uint32_t& shader)
 {
     int success = false;
     char log[1024] = {};
-    const auto vertexShaderSource = Slurp(vertexShaderFilePath);
-    const char* vertexShaderSourcePtr = vertexShaderSource.c_str();
-    const auto vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSourcePtr, nullptr);
-    glCompileShader(vertexShader);
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    const auto shaderSource = Slurp(filePath);
+    const char* shaderSourcePtr = shaderSource.c_str();
+    shader = glCreateShader(type);
+    glShaderSource(shader, 1, &shaderSourcePtr, nullptr);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
     {
-        glGetShaderInfoLog(vertexShader, 1024, nullptr, log);
+        glGetShaderInfoLog(shader, 1024, nullptr, log);
         spdlog::error(log);
+        glDeleteShader(shader);
         return false;
     }
 
-    const auto fragmentShaderSource = Slurp(fragmentShaderFilePath);
-    const char* fragmentShaderSourcePtr = fragmentShaderSource.c_str();
-    const auto fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSourcePtr, nullptr);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    return true;
+}
+
+static bool LinkProgram(std::initializer_list<uint32_t> shaders, uint32_t& program)
+{
+    int success = false;
+    char log[1024] = {};
+    program = glCreateProgram();
+    for (const auto shader : shaders)
+    {
+        glAttachShader(program, shader);
+    }
+    glLinkProgram(program);
+    for (const auto shader : shaders)
+    {
+        glDeleteShader(shader);
+    }
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success)
     {
-        glGetShaderInfoLog(fragmentShader, 1024, nullptr, log);
+        glGetProgramInfoLog(program, 1024, nullptr, log);
         spdlog::error(log);
+
         return false;
     }
 
-    _shaderProgram = glCreateProgram();
-    glAttachShader(_shaderProgram, vertexShader);
-    glAttachShader(_shaderProgram, fragmentShader);
-    glLinkProgram(_shaderProgram);
-    glGetProgramiv(_shaderProgram, GL_LINK_STATUS, &success);
-    if (!success)
+    return true;
+}
+
+bool ProjectApplication::MakeShader(std::string_view vertexShaderFilePath, std::string_view fragmentShaderFilePath, uint32_t& program)
+{
+    uint32_t vertexShader = 0;
+    if (!CompileShader(GL_VERTEX_SHADER, vertexShaderFilePath, vertexShader))
     {
-        glGetProgramInfoLog(_shaderProgram, 1024, nullptr, log);
-        spdlog::error(log);
+        return false;
+    }
+
+    // depth only programs get away without a fragment shader
+    if (fragmentShaderFilePath.empty())
+    {
+        return LinkProgram({ vertexShader }, program);
+    }
+
+    uint32_t fragmentShader = 0;
+    if (!CompileShader(GL_FRAGMENT_SHADER, fragmentShaderFilePath, fragmentShader))
+    {
+        glDeleteShader(vertexShader);
+        return false;
+    }
+
+    return LinkProgram({ vertexShader, fragmentShader }, program);
+}
+
+bool ProjectApplication::MakeComputeShader(std::string_view computeShaderFilePath, uint32_t& program)
+{
+    uint32_t computeShader = 0;
+    if (!CompileShader(GL_COMPUTE_SHADER, computeShaderFilePath, computeShader))
+    {
+        return false;
+    }
 
+    return LinkProgram({ computeShader }, program);
+}
+
+bool ProjectApplication::CreateOcclusionCulling()
+{
+    if (!MakeShader("./data/shaders/main.vs.glsl", "", _occlusion.DepthProgram) ||
+        !MakeComputeShader("./data/shaders/hiz.cs.glsl", _occlusion.HiZProgram) ||
+        !MakeComputeShader("./data/shaders/cull.cs.glsl", _occlusion.CullProgram))
+    {
         return false;
     }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    glCreateFramebuffers(1, &_occlusion.DepthPrepassFramebuffer);
+    glNamedFramebufferDrawBuffer(_occlusion.DepthPrepassFramebuffer, GL_NONE);
+    glCreateFramebuffers(1, &_occlusion.SceneFramebuffer);
+
+    // indexed by transform index, every mesh owns its transform
+    std::vector<glm::vec4> bounds(_cubes.Transforms.size() * 2);
+    for (const auto& mesh : _cubes.Meshes)
+    {
+        bounds[mesh.TransformIndex * 2 + 0] = mesh.BoundsMin;
+        bounds[mesh.TransformIndex * 2 + 1] = mesh.BoundsMax;
+    }
+    glCreateBuffers(1, &_occlusion.BoundsData);
+    glNamedBufferStorage(_occlusion.BoundsData, bounds.size() * sizeof(glm::vec4), bounds.data(), 0);
+
+    glCreateBuffers(_occlusion.StatisticsBuffers.size(), _occlusion.StatisticsBuffers.data());
+    for (const auto buffer : _occlusion.StatisticsBuffers)
+    {
+        glNamedBufferStorage(buffer, 3 * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    glCreateQueries(GL_SAMPLES_PASSED, _occlusion.SamplesPassedQueries.size(), _occlusion.SamplesPassedQueries.data());
 
     return true;
 }
@@ -268,13 +1075,28 @@ void ProjectApplication::LoadModel(std::string_view file)
             {
                 continue;
             }
-            uint32_t texture;
-            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+
+            // the build compresses model textures to a .ktx2 of the same name, the original is the fallback
+            auto compressedTexturePath = fs::path(texturePath).replace_extension("ktx2");
+            uint32_t texture = fs::exists(compressedTexturePath)
+                ? _textureStreamer.CreateTexture(compressedTexturePath.string())
+                : 0;
+            const auto isCompressed = texture != 0;
+            if (!isCompressed)
+            {
+                glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+            }
 
             glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
             glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            if (isCompressed)
+            {
+                _cubes.Textures.emplace_back(texture);
+                textureIds[texturePath] = _cubes.Textures.size() - 1;
+                continue;
+            }
 
             int32_t width = 0;
             int32_t height = 0;
@@ -285,6 +1107,7 @@ void ProjectApplication::LoadModel(std::string_view file)
             glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, textureData);
             glGenerateTextureMipmap(texture);
             stbi_image_free((void*)textureData);
+            _textureStreamer.TrackTexture(texture, width, height, levels);
             _cubes.Textures.emplace_back(texture);
             textureIds[texturePath] = _cubes.Textures.size() - 1;
         }
@@ -491,6 +1314,15 @@ void ProjectApplication::LoadModel(std::string_view file)
             info.IndexOffset,
             info.Indices.size() * sizeof(uint32_t),
             info.Indices.data());
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+        for (const auto& vertex : info.Vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+            _cubes.Positions.emplace_back(vertex.Position);
+        }
+        _cubes.Indices.insert(_cubes.Indices.end(), info.Indices.begin(), info.Indices.end());
         _cubes.Meshes.emplace_back(Mesh
         {
             (uint32_t)info.Indices.size(),
@@ -498,7 +1330,9 @@ void ProjectApplication::LoadModel(std::string_view file)
             (uint32_t)(info.IndexOffset / sizeof(uint32_t)),
             info.TransformIndex,
             info.BaseColorTexture,
-            info.NormalTexture
+            info.NormalTexture,
+            glm::vec4(boundsMin, 1.0f),
+            glm::vec4(boundsMax, 1.0f)
         });
     }
 }
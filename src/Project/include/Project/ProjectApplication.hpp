@@ -1,6 +1,11 @@
 #pragma once
 
 #include <Project.Library/Application.hpp>
+#include <Project.Library/ClusteredLighting.hpp>
+#include <Project.Library/DrawQueue.hpp>
+#include <Project.Library/SoftwareOcclusionCulling.hpp>
+#include <Project.Library/TextureStreamer.hpp>
+#include <Project.Library/ThreadPool.hpp>
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
@@ -10,6 +15,7 @@
 #include <string_view>
 #include <vector>
 #include <memory>
+#include <array>
 
 struct Vertex
 {
@@ -50,6 +56,9 @@ struct Mesh
     uint32_t TransformIndex = 0;
     uint32_t BaseColorTexture = 0;
     uint32_t NormalTexture = 0;
+    // local space, w is unused and only there to match std430 in cull.cs.glsl
+    glm::vec4 BoundsMin = {};
+    glm::vec4 BoundsMax = {};
 };
 
 struct Model
@@ -57,6 +66,9 @@ struct Model
     std::vector<Mesh> Meshes;
     std::vector<uint32_t> Textures;
     std::vector<glm::mat4> Transforms;
+    // CPU copies for the software occlusion rasterizer, offsets match the GPU buffers
+    std::vector<glm::vec3> Positions;
+    std::vector<uint32_t> Indices;
     uint32_t InputLayout;
     uint32_t VertexBuffer;
     uint32_t IndexBuffer;
@@ -65,12 +77,66 @@ struct Model
     uint32_t TransformData;
 };
 
+struct ObjectData
+{
+    uint32_t TransformIndex;
+    uint32_t BaseColorIndex;
+    uint32_t NormalIndex;
+};
+
+struct BatchData
+{
+    std::vector<ObjectData> Objects;
+    std::vector<MeshIndirectInfo> IndirectCommands;
+    std::vector<uint32_t> MeshIndices;
+    std::vector<uint32_t> Textures;
+};
+
+struct OcclusionStatistics
+{
+    uint32_t TestedMeshes = 0;
+    uint32_t FrustumRejectedMeshes = 0;
+    uint32_t OcclusionRejectedMeshes = 0;
+    // fragments that passed the depth test in the main pass per screen pixel
+    float Overdraw = 0.0f;
+};
+
+// GPU side of the clustered forward lighting, bindings match main.fs.glsl
+struct ClusteredLightingBuffers
+{
+    uint32_t Lights = 0;
+    uint32_t Clusters = 0;
+    uint32_t LightIndices = 0;
+    bool AreLightsDirty = true;
+};
+
+// GPU state for the depth pre-pass and Hi-Z occlusion culling, results are read back a few frames late
+struct OcclusionCulling
+{
+    static constexpr uint32_t FramesInFlight = 3;
+
+    uint32_t DepthProgram = 0;
+    uint32_t HiZProgram = 0;
+    uint32_t CullProgram = 0;
+    uint32_t DepthPrepassFramebuffer = 0;
+    uint32_t SceneFramebuffer = 0;
+    uint32_t BoundsData = 0;
+    std::array<uint32_t, FramesInFlight> StatisticsBuffers = {};
+    std::array<void*, FramesInFlight> StatisticsFences = {};
+    std::array<uint32_t, FramesInFlight> SamplesPassedQueries = {};
+    std::array<bool, FramesInFlight> IsQueryPending = {};
+    std::array<uint64_t, FramesInFlight> QueryPixelCounts = {};
+    uint32_t FrameIndex = 0;
+};
+
 class ProjectApplication final : public Application
 {
 protected:
     void AfterCreatedUiContext() override;
     void BeforeDestroyUiContext() override;
     bool Load() override;
+    void Unload() override;
+    RenderGraphResource BuildRenderGraph(RenderGraph& renderGraph, RenderGraphResource backbuffer, float deltaTime) override;
     void RenderScene(float deltaTime) override;
     void RenderUI(float deltaTime) override;
     void Update(float deltaTime) override;
@@ -78,9 +144,54 @@ protected:
 private:
     Model _cubes;
     uint32_t _shaderProgram;
+    std::vector<BatchData> _batches;
+    bool _hasUploadedBatches = false;
+
+    glm::mat4 _projection = glm::mat4(1.0f);
+    glm::mat4 _view = glm::mat4(1.0f);
+
+    bool _isDepthPrepassEnabled = true;
+    OcclusionCulling _occlusion;
+    OcclusionStatistics _occlusionStatistics;
+
+    ThreadPool _threadPool;
+    bool _isSoftwareOcclusionEnabled = false;
+    float _occluderMinimumCoverage = 0.01f;
+    int32_t _maxOccluders = 32;
+    SoftwareOcclusionCulling _softwareOcclusion;
+    OcclusionStatistics _softwareOcclusionStatistics;
+    std::vector<uint8_t> _meshVisibility;
+
+    bool _isDrawSortingEnabled = true;
+    DrawQueue _drawQueue;
+
+    bool _isClusteredLightingEnabled = true;
+    int32_t _lightCount = 1024;
+    std::vector<LightData> _lights;
+    ClusteredLighting _clusteredLighting;
+    ClusteredLightingBuffers _lightingBuffers;
+
+    TextureStreamer _textureStreamer;
+    bool _isTextureStreamingEnabled = true;
+    int32_t _textureUploadBudgetKiB = 4096;
 
     float _elapsedTime = 0.0f;
 
-    bool MakeShader(std::string_view vertexShaderFilePath, std::string_view fragmentShaderFilePath);
+    bool MakeShader(std::string_view vertexShaderFilePath, std::string_view fragmentShaderFilePath, uint32_t& program);
+    bool MakeComputeShader(std::string_view computeShaderFilePath, uint32_t& program);
     void LoadModel(std::string_view filePath);
+    bool CreateOcclusionCulling();
+    void UpdateSoftwareOcclusion();
+    void CreateClusteredLighting();
+    void GenerateLights(uint32_t lightCount, std::vector<LightData>& lights) const;
+    void UpdateClusteredLighting();
+    void UploadClusteredLighting(int32_t width, int32_t height);
+    void RequestTextureLevels(int32_t width, int32_t height);
+    void StreamTextures();
+
+    void UploadBatches();
+    void DrawBatches(bool bindTextures);
+    void BeginOverdrawQuery(uint64_t pixelCount);
+    void EndOverdrawQuery();
+    void ReadOcclusionStatistics();
 };
\ No newline at end of file